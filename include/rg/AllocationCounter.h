@@ -0,0 +1,13 @@
+#ifndef CG_PROJECT_ALLOCATIONCOUNTER_H
+#define CG_PROJECT_ALLOCATIONCOUNTER_H
+
+#include <cstdint>
+
+namespace rg {
+
+    // number of global operator new calls since the start of the program, on any thread;
+    // AllocationCounter.cpp replaces the global allocation functions to count them
+    std::uint64_t allocationCount();
+}
+
+#endif //CG_PROJECT_ALLOCATIONCOUNTER_H
@@ -0,0 +1,78 @@
+#ifndef CG_PROJECT_AUTOEXPOSURE_H
+#define CG_PROJECT_AUTOEXPOSURE_H
+
+#include <glad/glad.h>
+#include <vector>
+
+#include "rg/Shader.h"
+
+namespace rg {
+
+    // exposure that follows the average scene luminance: log luminance of the hdr buffer is averaged into
+    // a SIZE x SIZE texture, every texel over its whole block of hdr pixels, and halved by draws down to
+    // a single texel, the mean of the logs being the geometric mean luminance. the texel is read back
+    // through a ring of pixel buffers guarded by fences, a result is picked up once its fence has passed,
+    // so the CPU never waits for the GPU.
+    // glGenerateMipmap would do the reduction too, but some drivers (llvmpipe) run it on the CPU and wait for the frame
+    class AutoExposure {
+    public:
+        struct Settings {
+            // luminance the average is mapped to
+            float key = 0.18f;
+            float minExposure = 0.05f;
+            float maxExposure = 8.0f;
+            // how fast the exposure follows a change, per second
+            float adaptationRate = 1.5f;
+            // read the result back in the frame it is computed, waits for the GPU; for comparison only
+            bool sync = false;
+        };
+
+    private:
+        // has to match SIZE in luminance.fs
+        static const unsigned int SIZE = 256;
+        static const unsigned int RING = 3;
+
+        struct Level {
+            unsigned int texture;
+            unsigned int framebuffer;
+            int size;
+        };
+
+        struct Readback {
+            unsigned int buffer;
+            GLsync fence;
+            unsigned int frame;
+        };
+
+        Shader m_Luminance;
+        Uniform<bool> m_LuminanceReduce;
+        // SIZE down to 1x1, the last one is read back
+        std::vector<Level> m_Levels;
+        Readback m_Ring[RING];
+        // oldest slot, the next one to be written
+        unsigned int m_Next;
+        float m_AverageLuminance;
+        float m_Exposure;
+        unsigned int m_Frame;
+        unsigned int m_Latency;
+
+        void collect();
+
+    public:
+        AutoExposure();
+
+        // measures hdrTexture and moves the exposure towards the target for it;
+        // leaves the viewport at width x height and one of its own framebuffers bound
+        void update(unsigned int hdrTexture, float deltaTime, const Settings &settings,
+                    void (*drawQuad)(), int width, int height);
+
+        float getExposure() const;
+        float getAverageLuminance() const;
+        // frames between measuring and reading the result of the last readback
+        unsigned int getLatency() const;
+        void free();
+    };
+
+}
+
+#endif //CG_PROJECT_AUTOEXPOSURE_H
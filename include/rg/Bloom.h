@@ -0,0 +1,55 @@
+#ifndef CG_PROJECT_BLOOM_H
+#define CG_PROJECT_BLOOM_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "rg/Shader.h"
+
+namespace rg {
+
+    // progressive bloom over a chain of half resolution levels: the bright buffer is reduced
+    // with a 13-tap filter level by level, then each level is tent filtered and added to the next larger one.
+    // all levels together are about a third of the source, so the cost stays small at any resolution
+    class Bloom {
+    private:
+        struct Level {
+            unsigned int framebuffer;
+            unsigned int texture;
+            int width;
+            int height;
+        };
+
+        Shader m_Downsample;
+        Shader m_Upsample;
+        Uniform<glm::vec2> m_DownsampleTexel;
+        Uniform<bool> m_DownsampleKaris;
+        Uniform<glm::vec2> m_UpsampleRadius;
+
+        std::vector<Level> m_Levels;
+        unsigned int m_MaxLevels;
+        int m_Width;
+        int m_Height;
+
+        void createLevels();
+        void deleteLevels();
+
+    public:
+        // width and height of the source image, level 0 is half of it
+        Bloom(int width, int height, unsigned int maxLevels = 6);
+        void resize(int width, int height);
+
+        // blurs source into level 0 and returns its texture; radius is the tent filter spread
+        // in texels of the level being upsampled. drawQuad draws a full screen quad with
+        // positions at location 0 and texture coordinates at location 1.
+        // leaves the level 0 framebuffer bound and the viewport set to the source size
+        unsigned int render(unsigned int source, float radius, void (*drawQuad)());
+
+        unsigned int getLevelCount() const;
+        void free();
+    };
+
+}
+
+#endif //CG_PROJECT_BLOOM_H
@@ -0,0 +1,101 @@
+#ifndef CG_PROJECT_CLUSTEREDLIGHTING_H
+#define CG_PROJECT_CLUSTEREDLIGHTING_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "rg/Frustum.h"
+#include "rg/TextureBuffer.h"
+
+namespace rg {
+
+    // a point light as the scene shaders see it, diffuse already multiplied by the light color
+    struct PointLightData {
+        glm::vec3 position;
+        glm::vec3 ambient;
+        glm::vec3 diffuse;
+        glm::vec3 specular;
+        float constant;
+        float linear;
+        float quadratic;
+    };
+
+    // clustered forward shading: the view frustum is cut into GRID_X x GRID_Y screen tiles and GRID_Z
+    // exponential depth slices, every light is assigned on the CPU to the froxels its sphere of influence
+    // touches, and each fragment only shades the lights of its froxel.
+    // everything reaches the shaders through buffer textures bound from LIGHT_TEXTURE_UNIT on:
+    //   pointLights   RGBA32F, 4 texels per light: position + radius, ambient + constant, diffuse + linear, specular + quadratic
+    //   clusterLights RG32UI, offset and count into lightIndices per froxel, x fastest, then y, then z
+    //   lightIndices  R32UI
+    class ClusteredLighting {
+    public:
+        static const unsigned int GRID_X = 16;
+        static const unsigned int GRID_Y = 9;
+        static const unsigned int GRID_Z = 24;
+        static const unsigned int CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+        // pointLights, clusterLights and lightIndices on this unit and the two after it
+        static const unsigned int LIGHT_TEXTURE_UNIT = 8;
+
+    private:
+        // view space bounds of every froxel, rebuilt when the projection changes
+        std::vector<AABB> m_Clusters;
+        float m_FovY;
+        float m_Aspect;
+        float m_Near;
+        float m_Far;
+        int m_Width;
+        int m_Height;
+
+        std::vector<PointLightData> m_Lights;
+        std::vector<float> m_Radius;
+        // view space spheres of the lights in the current slice, padded to a multiple of 4
+        std::vector<float> m_SliceX;
+        std::vector<float> m_SliceY;
+        std::vector<float> m_SliceZ;
+        std::vector<float> m_SliceRadius;
+        std::vector<unsigned int> m_SliceLights;
+
+        std::vector<float> m_LightTexels;
+        std::vector<std::uint32_t> m_Grid;
+        std::vector<std::uint32_t> m_Indices;
+        unsigned int m_MaxLightsPerCluster;
+
+        TextureBuffer m_LightBuffer;
+        TextureBuffer m_GridBuffer;
+        TextureBuffer m_IndexBuffer;
+
+        void buildClusters();
+
+    public:
+        ClusteredLighting();
+
+        // fovY in radians; the froxels are only rebuilt if something changed
+        void setProjection(float fovY, float aspect, float near, float far, int width, int height);
+
+        void clearLights();
+        void addLight(const PointLightData &light);
+        // distance at which the brightest channel of the light falls under 5/256
+        static float lightRadius(const PointLightData &light);
+
+        // assigns the lights to froxels for this view and uploads the three buffers
+        void update(const glm::mat4 &view);
+        // uploads only pointLights, for passes that go over the lights themselves instead of the froxels
+        void uploadLights();
+        void bind() const;
+
+        // tiles across, tiles down, depth slices
+        glm::uvec4 getGrid() const;
+        // tile width and height in pixels, near plane, depth slices / log(far / near)
+        glm::vec4 getParams() const;
+
+        unsigned int getLightCount() const;
+        unsigned int getIndexCount() const;
+        unsigned int getMaxLightsPerCluster() const;
+        void free();
+    };
+
+}
+
+#endif //CG_PROJECT_CLUSTEREDLIGHTING_H
@@ -0,0 +1,56 @@
+#ifndef CG_PROJECT_COMPUTEPOSTPROCESS_H
+#define CG_PROJECT_COMPUTEPOSTPROCESS_H
+
+#include <glad/glad.h>
+
+#include "rg/Shader.h"
+
+namespace rg {
+
+    // gaussian bloom and the hdr resolve in two compute dispatches instead of a chain of full screen quads:
+    // the first blurs rows of the bright buffer through shared memory tiles, the second blurs the
+    // columns and tonemaps in the same pass. only usable if GLExtensions::hasCompute()
+    class ComputePostProcess {
+    private:
+        Shader m_Horizontal;
+        Shader m_Resolve;
+        Uniform<int> m_HorizontalRadius;
+        Uniform<float> m_HorizontalWeights;
+        Uniform<int> m_ResolveRadius;
+        Uniform<float> m_ResolveWeights;
+        Uniform<bool> m_ResolveHdr;
+        Uniform<bool> m_ResolveBloom;
+        Uniform<float> m_ResolveExposure;
+
+        // horizontal pass result
+        unsigned int m_BlurTexture;
+        // tonemapped image, blitted to the target framebuffer
+        unsigned int m_OutputTexture;
+        unsigned int m_OutputFramebuffer;
+        int m_Width;
+        int m_Height;
+        // sigma of the weights the programs hold
+        float m_Sigma;
+
+        void createTargets();
+        void deleteTargets();
+
+    public:
+        // has to match TILE in bloomHorizontal.cs and bloomResolve.cs
+        static const unsigned int TILE = 128;
+
+        ComputePostProcess(int width, int height);
+        // false if one of the programs failed to link, the fragment path has to be used then
+        bool isValid() const;
+        void resize(int width, int height);
+
+        // hdrTexture and brightTexture are the two color attachments of the scene framebuffer;
+        // the result is written to targetFramebuffer, which is left bound
+        void render(unsigned int hdrTexture, unsigned int brightTexture, float sigma,
+                    bool bloom, bool hdr, float exposure, unsigned int targetFramebuffer);
+        void free();
+    };
+
+}
+
+#endif //CG_PROJECT_COMPUTEPOSTPROCESS_H
@@ -0,0 +1,66 @@
+#ifndef CG_PROJECT_DEFERREDSHADING_H
+#define CG_PROJECT_DEFERREDSHADING_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <string>
+
+#include "rg/Shader.h"
+
+namespace rg {
+
+    // deferred alternative to lighting in every scene shader: the opaque pass only writes surface
+    // attributes to a G-buffer, then each point light is a sphere drawn over the pixels it can reach
+    // and a full screen pass adds the directional light. lighting costs per covered pixel, not per fragment drawn.
+    // G-buffer: albedo RGBA8, octahedral normal RG16F, specular color + shininess / 256 RGBA8, depth 24 bit
+    class DeferredShading {
+    private:
+        static const unsigned int TARGET_COUNT = 3;
+
+        Shader m_LightVolume;
+        Shader m_Resolve;
+        Uniform<glm::mat4> m_VolumeInverseViewProjection;
+        Uniform<glm::mat4> m_ResolveInverseViewProjection;
+
+        unsigned int m_GBuffer;
+        unsigned int m_Targets[TARGET_COUNT];
+        unsigned int m_Depth;
+        // sum of the light volumes
+        unsigned int m_LightBuffer;
+        unsigned int m_LightTexture;
+        // the hdr buffers with the G-buffer depth, for the resolve and the forward pass after it
+        unsigned int m_ForwardBuffer;
+        unsigned int m_ColorBuffer;
+        unsigned int m_BrightBuffer;
+        int m_Width;
+        int m_Height;
+
+        unsigned int m_SphereVAO;
+        unsigned int m_SphereVBO;
+        unsigned int m_SphereEBO;
+        GLsizei m_SphereIndexCount;
+
+        void createTargets();
+        void deleteTargets();
+        void createSphere();
+
+    public:
+        // colorBuffer and brightBuffer are the two hdr color buffers the resolve writes to
+        DeferredShading(int width, int height, unsigned int colorBuffer, unsigned int brightBuffer);
+        // the hdr buffers have to be resized to the same size beforehand
+        void resize(int width, int height);
+        void bindUniformBlock(const std::string &blockName, unsigned int binding) const;
+
+        // binds and clears the G-buffer and disables blending, the opaque pass is drawn into it
+        void beginGeometry();
+        // lights the G-buffer into the hdr buffers. the point lights are read from the pointLights
+        // buffer texture of ClusteredLighting, which has to be bound. leaves the forward framebuffer bound,
+        // its depth is the G-buffer's, so transparent objects can be drawn right after
+        void light(unsigned int lightCount, const glm::mat4 &inverseViewProjection, void (*drawQuad)());
+
+        void free();
+    };
+
+}
+
+#endif //CG_PROJECT_DEFERREDSHADING_H
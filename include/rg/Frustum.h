@@ -0,0 +1,42 @@
+#ifndef CG_PROJECT_FRUSTUM_H
+#define CG_PROJECT_FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+namespace rg {
+
+    struct AABB {
+        glm::vec3 min = glm::vec3(0.0f);
+        glm::vec3 max = glm::vec3(0.0f);
+
+        glm::vec3 center() const { return (min + max) * 0.5f; }
+        glm::vec3 extents() const { return (max - min) * 0.5f; }
+        void expand(const AABB &other) {
+            min = glm::min(min, other.min);
+            max = glm::max(max, other.max);
+        }
+        void expand(const glm::vec3 &point) {
+            min = glm::min(min, point);
+            max = glm::max(max, point);
+        }
+    };
+
+    // the six clip planes of a view-projection matrix (left, right, bottom, top, near, far),
+    // normalized and pointing inwards: dot(xyz, p) + w >= 0 for points inside
+    class Frustum {
+    private:
+        glm::vec4 m_Planes[6];
+
+    public:
+        Frustum();
+        explicit Frustum(const glm::mat4 &viewProjection);
+
+        const glm::vec4 &getPlane(unsigned int i) const;
+        // box is in model space, tested after transforming it to world space by model
+        bool intersects(const AABB &box, const glm::mat4 &model) const;
+        bool intersects(const glm::vec3 &center, float radius) const;
+    };
+
+}
+
+#endif //CG_PROJECT_FRUSTUM_H
@@ -0,0 +1,92 @@
+#ifndef CG_PROJECT_GLEXTENSIONS_H
+#define CG_PROJECT_GLEXTENSIONS_H
+
+#include <glad/glad.h>
+
+// enums above GL 3.3 core, glad is generated for 3.3 only
+#ifndef GL_COMPUTE_SHADER
+#define GL_COMPUTE_SHADER 0x91B9
+#endif
+#ifndef GL_SHADER_IMAGE_ACCESS_BARRIER_BIT
+#define GL_SHADER_IMAGE_ACCESS_BARRIER_BIT 0x00000020
+#endif
+#ifndef GL_TEXTURE_FETCH_BARRIER_BIT
+#define GL_TEXTURE_FETCH_BARRIER_BIT 0x00000008
+#endif
+#ifndef GL_FRAMEBUFFER_BARRIER_BIT
+#define GL_FRAMEBUFFER_BARRIER_BIT 0x00000400
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#endif
+#ifndef GL_SHADER_STORAGE_BARRIER_BIT
+#define GL_SHADER_STORAGE_BARRIER_BIT 0x00002000
+#endif
+#ifndef GL_COMMAND_BARRIER_BIT
+#define GL_COMMAND_BARRIER_BIT 0x00000040
+#endif
+#ifndef GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT
+#define GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT 0x00000001
+#endif
+
+namespace rg {
+
+    // GL 4.x entry points resolved at runtime with the loader glad was initialized with.
+    // the context is created as 3.3 core, but most drivers hand out the newest core version they have;
+    // a pointer is only set if the context supports it, check the has* queries before calling
+    class GLExtensions {
+    private:
+        static int s_Major;
+        static int s_Minor;
+        static bool s_Compute;
+        static bool s_BufferStorage;
+        static bool s_MultiDrawIndirect;
+        static bool s_DrawIndirect;
+        static bool s_ShaderStorage;
+
+    public:
+        typedef void (APIENTRYP DispatchComputeProc)(GLuint groupsX, GLuint groupsY, GLuint groupsZ);
+        typedef void (APIENTRYP BindImageTextureProc)(GLuint unit, GLuint texture, GLint level, GLboolean layered,
+                                                      GLint layer, GLenum access, GLenum format);
+        typedef void (APIENTRYP MemoryBarrierProc)(GLbitfield barriers);
+        typedef void (APIENTRYP BufferStorageProc)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+        typedef void (APIENTRYP DrawElementsIndirectProc)(GLenum mode, GLenum type, const void *indirect);
+        typedef void (APIENTRYP MultiDrawElementsIndirectProc)(GLenum mode, GLenum type, const void *indirect, GLsizei drawCount,
+                                                               GLsizei stride);
+
+        static DispatchComputeProc dispatchCompute;
+        static BindImageTextureProc bindImageTexture;
+        static MemoryBarrierProc memoryBarrier;
+        static BufferStorageProc bufferStorage;
+        static DrawElementsIndirectProc drawElementsIndirect;
+        static MultiDrawElementsIndirectProc multiDrawElementsIndirect;
+
+        // once, after gladLoadGLLoader succeeded
+        static void load(GLADloadproc loader);
+
+        static bool hasVersion(int major, int minor);
+        static bool hasExtension(const char *name);
+        // compute shaders and image load/store, GL 4.3
+        static bool hasCompute();
+        // immutable buffers that stay mapped while they are drawn from, GL 4.4 or ARB_buffer_storage
+        static bool hasBufferStorage();
+        // glDrawElementsIndirect, GL 4.0 or ARB_draw_indirect
+        static bool hasDrawIndirect();
+        // glMultiDrawElementsIndirect with baseInstance honoured, GL 4.3 or ARB_multi_draw_indirect + ARB_base_instance
+        static bool hasMultiDrawIndirect();
+        // std430 buffer blocks, GL 4.3 or ARB_shader_storage_buffer_object
+        static bool hasShaderStorage();
+    };
+
+}
+
+#endif //CG_PROJECT_GLEXTENSIONS_H
@@ -0,0 +1,84 @@
+#ifndef CG_PROJECT_GLSTATE_H
+#define CG_PROJECT_GLSTATE_H
+
+#include <glad/glad.h>
+
+namespace rg {
+
+    // shadow copy of the bind and fixed function state of the current context,
+    // a call that would set a value that is already in place never reaches the driver;
+    // every bind in the project has to go through here or the copy goes stale.
+    // the setters return true if the call was forwarded
+    class GLState {
+    private:
+        static const unsigned int TEXTURE_UNITS = 32;
+        static const unsigned int UNKNOWN = 0xffffffffu;
+
+        static unsigned int s_Program;
+        static unsigned int s_VertexArray;
+        static unsigned int s_Framebuffer;
+        static unsigned int s_ActiveUnit;
+        static unsigned int s_Textures[TEXTURE_UNITS];
+        static unsigned int s_Blend;
+        static unsigned int s_CullFace;
+        static unsigned int s_DepthTest;
+        static GLenum s_BlendSrc;
+        static GLenum s_BlendDst;
+        static GLenum s_CullMode;
+        static GLenum s_FrontFace;
+        static GLenum s_DepthFunc;
+        static unsigned int s_DepthMask;
+        static unsigned int s_ColorMask;
+        static int s_Viewport[4];
+
+        static bool s_Elide;
+        static unsigned int s_Calls;
+        static unsigned int s_Elided;
+        static unsigned int s_CallsLastFrame;
+        static unsigned int s_ElidedLastFrame;
+
+        static bool change(unsigned int &current, unsigned int value);
+        static unsigned int *capability(GLenum cap);
+
+    public:
+        // forget everything, the next call of each kind is forwarded;
+        // needed after creating a context or running code that binds behind our back
+        static void reset();
+
+        static bool useProgram(unsigned int program);
+        static bool bindVertexArray(unsigned int vao);
+        // GL_FRAMEBUFFER, draw and read together
+        static bool bindFramebuffer(unsigned int framebuffer);
+        static bool activeTexture(unsigned int unit);
+        // GL_TEXTURE_2D on the given unit, or on the active unit
+        static bool bindTexture(unsigned int unit, unsigned int texture);
+        static bool bindTexture(unsigned int texture);
+
+        // GL_BLEND, GL_CULL_FACE and GL_DEPTH_TEST are tracked, anything else is always forwarded
+        static bool enable(GLenum cap);
+        static bool disable(GLenum cap);
+        static bool blendFunc(GLenum src, GLenum dst);
+        static bool cullFace(GLenum mode);
+        static bool frontFace(GLenum mode);
+        static bool depthFunc(GLenum func);
+        static bool depthMask(bool mask);
+        // all four channels together
+        static bool colorMask(bool mask);
+        static bool viewport(int x, int y, int width, int height);
+
+        // deleting an object unbinds it, so its id can't be mistaken for a later object with the same id
+        static void deleteProgram(unsigned int program);
+        static void deleteVertexArrays(int count, const unsigned int *vaos);
+        static void deleteFramebuffers(int count, const unsigned int *framebuffers);
+        static void deleteTextures(int count, const unsigned int *textures);
+
+        // with elision off every call is forwarded, for comparing driver call counts
+        static void setElide(bool elide);
+        static unsigned int callsLastFrame();
+        static unsigned int elidedLastFrame();
+        static void endFrame();
+    };
+
+}
+
+#endif //CG_PROJECT_GLSTATE_H
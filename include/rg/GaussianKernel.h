@@ -0,0 +1,34 @@
+#ifndef CG_PROJECT_GAUSSIANKERNEL_H
+#define CG_PROJECT_GAUSSIANKERNEL_H
+
+namespace rg {
+
+    // one side of a separable gaussian, folded for bilinear filtering: tap 0 is the center texel,
+    // every other tap sits between two texels at the offset where a single linear fetch
+    // returns both of them in the right proportion, so 2r + 1 fetches become r + 1 (r even)
+    struct GaussianKernel {
+        // has to match MAX_TAPS in bloom.fs
+        static const unsigned int MAX_TAPS = 16;
+        static const unsigned int MAX_RADIUS = 2 * (MAX_TAPS - 1);
+
+        // texels covered on each side of the center
+        unsigned int radius;
+        unsigned int tapCount;
+        // in texels, offsets[0] is always 0
+        float offsets[MAX_TAPS];
+        float weights[MAX_TAPS];
+        // the same kernel unfolded, index is the distance from the center;
+        // for filters that read single texels, like the compute blur
+        float discreteWeights[MAX_RADIUS + 1];
+
+        // covers 3 sigma, clamped to what fits into MAX_TAPS
+        static GaussianKernel make(float sigma);
+
+        // texture fetches per pixel and pass, with and without the folding
+        unsigned int fetchCount() const;
+        unsigned int discreteFetchCount() const;
+    };
+
+}
+
+#endif //CG_PROJECT_GAUSSIANKERNEL_H
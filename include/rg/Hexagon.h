@@ -8,6 +8,7 @@
 #include <vector>
 #include <glm/glm.hpp>
 #include <GLFW/glfw3.h>
+#include "rg/RenderQueue.h"
 
 namespace rg {
 
@@ -29,6 +30,7 @@ namespace rg {
 
         Hexagon(std::vector<float> &pos, std::vector<float> &tex, bool ind);
         void drawHexagon();
+        void submitHexagon(RenderQueue &queue, DrawItem item, RenderPass pass, float depth);
         void free();
     };
 
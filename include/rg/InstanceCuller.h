@@ -0,0 +1,43 @@
+#ifndef CG_PROJECT_INSTANCECULLER_H
+#define CG_PROJECT_INSTANCECULLER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "rg/Frustum.h"
+
+namespace rg {
+
+    // bounding spheres of the instances of one model, kept as structure of arrays
+    // so the plane tests run on four instances at a time; instance i is the caller's i-th matrix
+    class InstanceCuller {
+    private:
+        glm::vec3 m_Center;
+        float m_BoundsRadius;
+        // padded to a multiple of 4, the padding lanes have a negative radius and are never visible
+        std::vector<float> m_X;
+        std::vector<float> m_Y;
+        std::vector<float> m_Z;
+        std::vector<float> m_Radius;
+        unsigned int m_Count = 0;
+        std::vector<unsigned int> m_Visible;
+
+    public:
+        // bounds are the model space bounds of the instanced model
+        explicit InstanceCuller(const AABB &bounds);
+
+        void add(const glm::mat4 &matrix);
+        void set(unsigned int index, const glm::mat4 &matrix);
+        // moves the last instance into index, the caller does the same with its matrices
+        void removeSwap(unsigned int index);
+
+        // indices of the instances whose sphere touches the frustum, in increasing order
+        const std::vector<unsigned int> &cull(const Frustum &frustum);
+        unsigned int getCount() const;
+        unsigned int getVisibleCount() const;
+    };
+
+}
+
+#endif //CG_PROJECT_INSTANCECULLER_H
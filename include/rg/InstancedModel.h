@@ -0,0 +1,125 @@
+#ifndef CG_PROJECT_INSTANCEDMODEL_H
+#define CG_PROJECT_INSTANCEDMODEL_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+
+#include "rg/Model.h"
+#include "rg/InstanceCuller.h"
+#include "rg/RenderQueue.h"
+
+namespace rg {
+
+    // draws every mesh of a Model once per frame for a changing set of instances, one instanced draw per mesh.
+    // the instance data of the visible instances is rewritten every frame into a buffer that stays mapped
+    // (three regions fenced against the GPU) where buffer storage is available, otherwise into an orphaned one.
+    // the model matrix goes to attributes 3-6, extra streams to their own locations; it takes over those
+    // attributes of the model's mesh VAOs, so there is one InstancedModel per Model.
+    // with GPU culling the instances go to a shader storage buffer only when they change; every frame
+    // instanceCull.cs appends the visible ones to a second buffer the VAOs read from, and instanceCommands.cs
+    // writes their number into one DrawElementsIndirectCommand per mesh, so nothing comes back to the CPU
+    class InstancedModel {
+    public:
+        typedef unsigned int InstanceId;
+        static const InstanceId INVALID_INSTANCE = 0xffffffffu;
+        // has to match local_size_x in instanceCull.cs
+        static const unsigned int CULL_GROUP_SIZE = 256;
+
+    private:
+        static const unsigned int REGIONS = 3;
+
+        struct Stream {
+            unsigned int location;
+            unsigned int components;
+            std::vector<float> values;
+        };
+
+        struct MeshTextures {
+            unsigned int textures[MAX_DRAW_TEXTURES];
+            unsigned int count;
+        };
+
+        Model &m_Model;
+        InstanceCuller m_Culler;
+
+        // dense, instance slot order; removing an instance moves the last one into its slot
+        std::vector<glm::mat4> m_Matrices;
+        std::vector<Stream> m_Streams;
+        std::vector<InstanceId> m_SlotIds;
+        std::vector<unsigned int> m_IdSlots;
+        std::vector<InstanceId> m_FreeIds;
+
+        // diffuse and specular map of every mesh, the diffuse one twice if it has no specular map
+        std::vector<MeshTextures> m_MeshTextures;
+
+        bool m_Persistent;
+        unsigned int m_Buffer = 0;
+        unsigned int m_Capacity = 0;
+        char *m_Mapped = nullptr;
+        GLsync m_Fences[REGIONS] = {};
+        unsigned int m_Region = 0;
+        // offset the mesh VAOs currently read from, -1 after the buffer was replaced
+        long m_BoundOffset = -1;
+        unsigned int m_VisibleCount = 0;
+
+        // GPU culling: m_Buffer holds every instance as one record, matrix then streams, and m_CulledBuffer the visible ones
+        bool m_GpuCulling;
+        std::unique_ptr<Shader> m_CullShader;
+        std::unique_ptr<Shader> m_CommandShader;
+        Uniform<int> m_CullInstanceCount;
+        Uniform<int> m_CullStride;
+        Uniform<glm::vec4> m_CullBoundingSphere;
+        Uniform<glm::vec4> m_CullPlanes;
+        glm::vec4 m_BoundingSphere;
+        unsigned int m_CulledBuffer = 0;
+        unsigned int m_CounterBuffer = 0;
+        unsigned int m_CommandBuffer = 0;
+        std::vector<DrawElementsIndirectCommand> m_Commands;
+        // slots changed since the last upload, [m_DirtyBegin, m_DirtyEnd)
+        unsigned int m_DirtyBegin = 0;
+        unsigned int m_DirtyEnd = 0;
+        std::vector<float> m_Staging;
+
+        std::size_t getInstanceSize() const;
+        void allocate(unsigned int capacity);
+        void releaseBuffers();
+        void bindAttributes(std::size_t offset);
+        void writeInstances(char *destination, const std::vector<unsigned int> *visible);
+        void markDirty(unsigned int begin, unsigned int end);
+        void uploadDirty();
+        void cullOnGpu(const Frustum *frustum);
+
+    public:
+        // model has to be ready; persistent = false always uses the orphaning path;
+        // gpuCulling needs supportsGpuCulling(), without it the instances are culled on the CPU
+        explicit InstancedModel(Model &model, bool persistent = true, bool gpuCulling = false);
+
+        // compute shaders, shader storage blocks and indirect draws
+        static bool supportsGpuCulling();
+
+        // components floats per instance at attribute location, zero for instances already there
+        unsigned int addStream(unsigned int location, unsigned int components);
+        InstanceId add(const glm::mat4 &matrix);
+        void remove(InstanceId id);
+        void update(InstanceId id, const glm::mat4 &matrix);
+        void setStream(InstanceId id, unsigned int stream, const float *values);
+
+        // once per frame before Submit: culls against frustum, if there is one, and writes the visible instances;
+        // returns how many are visible, or all of them with GPU culling, which never reads the count back
+        unsigned int prepare(const Frustum *frustum);
+        // every mesh of the model with the visible instances, textures from the mesh unless item has its own
+        void Submit(RenderQueue &queue, const DrawItem &item, RenderPass pass, float depth) const;
+
+        unsigned int getCount() const;
+        // getCount() with GPU culling
+        unsigned int getVisibleCount() const;
+        bool isPersistent() const;
+        bool isGpuCulled() const;
+        void free();
+    };
+
+}
+
+#endif //CG_PROJECT_INSTANCEDMODEL_H
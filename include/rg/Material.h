@@ -0,0 +1,51 @@
+#ifndef CG_PROJECT_MATERIAL_H
+#define CG_PROJECT_MATERIAL_H
+
+#include <string>
+#include <vector>
+
+#include "rg/Shader.h"
+#include "rg/RenderQueue.h"
+
+namespace rg {
+
+    struct Texture {
+        unsigned int id;
+        std::string type; // texture_diffuse, texture_specular, texture_normal, texture_height
+        std::string path;
+    };
+
+    // the textures of a mesh with their units and sampler names fixed at load, texture i goes to unit i;
+    // sampler locations are resolved the first time a program is seen and cached by program id
+    class Material {
+    private:
+        struct Binding {
+            unsigned int texture;
+            // texture_diffuse1, texture_specular1, ...
+            std::string sampler;
+        };
+
+        struct ProgramSamplers {
+            unsigned int program;
+            std::vector<int> locations;
+        };
+
+        std::vector<Binding> m_Bindings;
+        std::vector<ProgramSamplers> m_Programs;
+
+        const std::vector<int> &locationsFor(const Shader &shader);
+
+    public:
+        Material() = default;
+        explicit Material(const std::vector<Texture> &textures);
+
+        // sets the samplers of shader, which has to be in use, and binds the textures;
+        // no allocations once the program has been bound with this material
+        void bind(const Shader &shader);
+        // copies the texture ids into item, at most MAX_DRAW_TEXTURES
+        void fill(DrawItem &item) const;
+        unsigned int getTextureCount() const;
+    };
+}
+
+#endif //CG_PROJECT_MATERIAL_H
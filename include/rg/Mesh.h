@@ -10,6 +10,10 @@
 #include <vector>
 // #include <rg/Error.h>
 #include <rg/Shader.h>
+#include <rg/RenderQueue.h>
+#include <rg/Frustum.h>
+#include <rg/PackedVertex.h>
+#include <rg/Material.h>
 
 namespace rg {
 
@@ -22,25 +26,70 @@ namespace rg {
         glm::vec3 Bitangent;
     };
 
-    struct Texture {
-        unsigned int id;
-        std::string type; // texture_diffuse, texture_specular, texture_normal, texture_height
-        std::string path;
+    // CPU side result of importing one mesh, textures index into the model texture table
+    struct MeshData {
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        std::vector<unsigned int> textures;
+        AABB bounds;
     };
 
+    GLenum indexTypeFor(std::size_t vertexCount);
+    std::size_t indexTypeSize(GLenum indexType);
+    // points attributes 0-4 of the bound VAO at the bound GL_ARRAY_BUFFER laid out as format,
+    // or only the position for the depth VAOs
+    void setVertexAttributes(VertexFormat format, bool positionOnly = false);
+
     class Mesh {
     private:
-        void setupMesh();
+        // model space from the packed positions, identity for VERTEX_FULL
+        glm::mat4 m_PositionDecode;
+        // textures with their units and sampler names, built once from textures
+        Material m_Material;
+
+        void setupMesh(const Vertex *vs, const unsigned int *ind, const PackedVertex *packed, const AABB &packedBounds);
 
     public:
+        // CPU copies of the geometry, empty once it is on the GPU unless the mesh was made with keepGeometry
         std::vector<Vertex> vertices;
         std::vector<unsigned int> indices;
         std::vector<Texture> textures;
+        // model space, filled in by the importer
+        AABB bounds;
+
+        VertexFormat format;
+        // GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, the smallest that fits the vertex count
+        GLenum indexType;
+        // kept for the draws when the CPU copies are gone
+        std::size_t vertexCount;
+        GLsizei indexCount;
 
-        Mesh(const std::vector<Vertex> &vs, const std::vector<unsigned int> &ind, const std::vector<Texture> &tex);
+        // with VERTEX_PACKED the GPU only gets PackedVertex; keepGeometry leaves vertices and indices
+        // filled in as imported, for picking or physics, otherwise they are released after the upload
+        Mesh(std::vector<Vertex> vs, std::vector<unsigned int> ind, const std::vector<Texture> &tex,
+             VertexFormat vertexFormat = VERTEX_FULL, bool keepGeometry = false);
+        // uploads straight from vs and ind, they are only copied with keepGeometry; with VERTEX_PACKED, packed
+        // if given is uploaded as it is instead of packing vs, quantized against packedBounds, the bounds of vs
+        Mesh(const Vertex *vs, std::size_t vertexCount, const unsigned int *ind, std::size_t indexCount, const std::vector<Texture> &tex,
+             VertexFormat vertexFormat = VERTEX_FULL, bool keepGeometry = false,
+             const PackedVertex *packed = nullptr, const AABB &packedBounds = AABB());
+        // full format only, asserts on a packed mesh, which needs its position decode in the model matrix, see Submit
         void Draw(Shader &shader);
+        // queues the mesh with item as the template, textures set in item win over the mesh's own;
+        // PASS_DEPTH draws depthVAO without any textures. a packed mesh multiplies item.model by its position decode
+        void Submit(RenderQueue &queue, DrawItem item, RenderPass pass, float depth) const;
+        std::size_t getVertexBufferSize() const;
+        std::size_t getIndexBufferSize() const;
+        // CPU bytes the mesh still holds
+        std::size_t getResidentSize() const;
+        const glm::mat4 &getPositionDecode() const;
+        const Material &getMaterial() const;
 
         unsigned int VAO;
+        // the same buffers with only the position attribute enabled, for the depth pre-pass
+        unsigned int depthVAO;
+        unsigned int VBO;
+        unsigned int EBO;
     };
 }
 
@@ -0,0 +1,58 @@
+#ifndef CG_PROJECT_MESHCACHE_H
+#define CG_PROJECT_MESHCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "rg/Model.h"
+
+namespace rg {
+
+    // binary copy of an imported model kept next to the asset (scene.gltf -> scene.gltf.rgcache),
+    // the file is memory-mapped and its vertex and index arrays are handed to GL as they are.
+    // every mesh is stored both as rg::Vertex and as rg::PackedVertex, a load only touches the pages it uploads
+    class MeshCache {
+    private:
+        void *m_Mapping = nullptr;
+        std::size_t m_Size = 0;
+        std::vector<Texture> m_Textures;
+        const char *m_Meshes = nullptr;
+        unsigned int m_MeshCount = 0;
+
+        void close();
+
+    public:
+        struct MeshView {
+            const Vertex *vertices;
+            // the same vertices packed against bounds
+            const PackedVertex *packedVertices;
+            std::size_t vertexCount;
+            const unsigned int *indices;
+            std::size_t indexCount;
+            const unsigned int *textures;
+            std::size_t textureCount;
+            AABB bounds;
+        };
+
+        MeshCache() = default;
+        MeshCache(const MeshCache &) = delete;
+        MeshCache &operator=(const MeshCache &) = delete;
+        ~MeshCache();
+
+        // fails if the file is missing, truncated, written by another version or for other source data
+        bool open(const std::string &cachePath, std::uint64_t sourceHash);
+        unsigned int getMeshCount() const;
+        MeshView getMesh(unsigned int i) const;
+        const std::vector<Texture> &getTextures() const;
+
+        static bool write(const std::string &cachePath, std::uint64_t sourceHash, const ModelData &data);
+        // hash of the model file and the binary buffers next to it
+        static std::uint64_t hashSource(const std::string &modelPath);
+        static std::string pathFor(const std::string &modelPath);
+    };
+
+}
+
+#endif //CG_PROJECT_MESHCACHE_H
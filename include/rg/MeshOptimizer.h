@@ -0,0 +1,37 @@
+#ifndef CG_PROJECT_MESHOPTIMIZER_H
+#define CG_PROJECT_MESHOPTIMIZER_H
+
+#include <cstddef>
+#include <vector>
+
+#include "rg/Mesh.h"
+
+namespace rg {
+
+    // post-transform cache behaviour of an index buffer, simulated with a FIFO of cacheSize vertices
+    struct VertexCacheStats {
+        // vertex shader runs per triangle, 0.5 is the best a regular grid can do, 3 means no reuse at all
+        float acmr = 0.0f;
+        // vertex shader runs per vertex, 1 is optimal
+        float atvr = 0.0f;
+        std::size_t triangles = 0;
+        std::size_t vertices = 0;
+        std::size_t transforms = 0;
+    };
+
+    VertexCacheStats analyzeVertexCache(const unsigned int *indices, std::size_t indexCount, std::size_t vertexCount,
+                                        unsigned int cacheSize = 16);
+
+    // Tom Forsyth's linear-speed vertex cache optimisation, reorders the triangles in place
+    void optimizeVertexCache(std::vector<unsigned int> &indices, std::size_t vertexCount);
+    // splits the triangle order where the cache starts cold anyway and sorts those clusters so that the ones
+    // facing away from the mesh centre come first, they tend to hide the rest; keeps the cache order inside a cluster
+    void optimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<Vertex> &vertices);
+    // puts the vertices in the order the triangles first use them and drops unreferenced ones
+    void optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices);
+
+    // all of the above in order, with the cache statistics before and after
+    void optimizeMesh(MeshData &mesh, bool sortForOverdraw, VertexCacheStats *before = nullptr, VertexCacheStats *after = nullptr);
+}
+
+#endif //CG_PROJECT_MESHOPTIMIZER_H
@@ -10,6 +10,7 @@
 
 #include "rg/Shader.h"
 #include "rg/Mesh.h"
+#include "rg/TextureLoader.h"
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
@@ -18,23 +19,66 @@
 
 namespace rg {
 
+    // everything the importer produces before anything is sent to the GPU,
+    // texture ids are assigned once the table is uploaded
+    struct ModelData {
+        std::vector<MeshData> meshes;
+        std::vector<Texture> textures;
+    };
+
     class Model {
     private:
-        void loadModel(std::string path);
-        void processNode(aiNode *node, const aiScene *scene);
-        Mesh processMesh(aiMesh *mesh, const aiScene *scene);
-        void loadTextureMaterial(aiMaterial *mat, aiTextureType type, std::string typeName, std::vector<Texture> &textures);
+        friend class ModelLoader;
+
+        TextureLoader *m_TextureLoader;
+        VertexFormat m_VertexFormat;
+        bool m_KeepGeometry;
+        bool m_Ready;
+
+        // empty model that a ModelLoader fills in over several frames
+        Model();
+
+        void loadModel(std::string path, bool useCache);
+        void importModel(std::string path, ModelData &data);
+        void processNode(aiNode *node, const aiScene *scene, ModelData &data);
+        MeshData processMesh(aiMesh *mesh, const aiScene *scene, ModelData &data);
+        void loadTextureMaterial(aiMaterial *mat, aiTextureType type, std::string typeName, ModelData &data, std::vector<unsigned int> &textures);
+        void loadTextures(const std::vector<Texture> &textures);
+        void addMesh(const Vertex *vertices, std::size_t vertexCount, const unsigned int *indices, std::size_t indexCount,
+                     const unsigned int *textureIndices, std::size_t textureCount, const AABB &bounds,
+                     const PackedVertex *packedVertices = nullptr);
+        // takes over the imported vertices and indices
+        void addMesh(MeshData &&mesh);
 
     public:
         std::vector<Mesh> meshes;
         std::vector<Texture> loaded_textures;
         std::string directory;
 
-        Model(std::string path);
+        // with a textureLoader the textures are decoded in the background and
+        // only usable after its finish(); useCache = false always runs Assimp and leaves the mesh cache alone;
+        // vertexFormat is what the meshes keep on the GPU, the mesh cache always holds full vertices;
+        // keepGeometry leaves the CPU copies in every Mesh, see the Mesh constructor
+        Model(std::string path, TextureLoader *textureLoader = nullptr, bool useCache = true, VertexFormat vertexFormat = VERTEX_FULL,
+              bool keepGeometry = false);
+        // does nothing until the model is completely on the GPU; VERTEX_FULL only, like Mesh::Draw
         void Draw(Shader &shader);
+        bool isReady() const;
+        // queues every mesh, see Mesh::Submit; does nothing until the model is ready.
+        // with a frustum, meshes whose bounds transformed by item.model are outside of it are left out
+        void Submit(RenderQueue &queue, const DrawItem &item, RenderPass pass, float depth, const Frustum *frustum = nullptr) const;
+        // union of the mesh bounds, model space
+        AABB getBounds() const;
+        VertexFormat getVertexFormat() const;
+        // vertex buffer bytes of all meshes
+        std::size_t getVertexBufferSize() const;
+        // index buffer bytes of all meshes, each mesh with its own index type
+        std::size_t getIndexBufferSize() const;
+        // CPU bytes the meshes still hold
+        std::size_t getResidentSize() const;
     };
 
     unsigned int TextureFromFile(const char *filename, std::string directory);
 }
 
-#endif //CG_PROJECT_MODEL_H
\ No newline at end of file
+#endif //CG_PROJECT_MODEL_H
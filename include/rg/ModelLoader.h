@@ -0,0 +1,70 @@
+#ifndef CG_PROJECT_MODELLOADER_H
+#define CG_PROJECT_MODELLOADER_H
+
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <string>
+
+#include "rg/Model.h"
+#include "rg/MeshCache.h"
+#include "rg/TextureLoader.h"
+#include "rg/ThreadPool.h"
+
+namespace rg {
+
+    // shared reference to a model that may still be streaming in
+    class ModelHandle {
+    private:
+        std::shared_ptr<Model> m_Model;
+
+    public:
+        ModelHandle() = default;
+        explicit ModelHandle(std::shared_ptr<Model> model);
+
+        bool isReady() const;
+        Model &operator*() const;
+        Model *operator->() const;
+    };
+
+    // imports models on a ThreadPool and moves them to the GPU a little every frame:
+    // request() returns at once, update() on the context thread uploads under a time budget
+    class ModelLoader {
+    private:
+        struct Job {
+            std::shared_ptr<Model> model;
+            std::string path;
+
+            // written by the worker before parsed is set
+            std::atomic<bool> parsed{false};
+            ModelData data;
+            std::unique_ptr<MeshCache> cache;
+
+            // upload progress, context thread only
+            bool texturesRequested = false;
+            std::size_t lastTextureRequest = 0;
+            unsigned int nextMesh = 0;
+        };
+
+        ThreadPool &m_Pool;
+        TextureLoader &m_TextureLoader;
+        std::list<std::shared_ptr<Job>> m_Jobs;
+
+        static void parse(Job &job);
+        // returns true once the job's model is complete
+        bool upload(Job &job, std::chrono::steady_clock::time_point deadline, bool &uploadedAny);
+
+    public:
+        ModelLoader(ThreadPool &pool, TextureLoader &textureLoader);
+
+        // vertexFormat and keepGeometry as in the Model constructor
+        ModelHandle request(const std::string &path, VertexFormat vertexFormat = VERTEX_FULL, bool keepGeometry = false);
+        // uploads pending textures and meshes for at most budgetMs milliseconds, at least one item per call
+        void update(double budgetMs);
+        unsigned int getPendingCount() const;
+    };
+
+}
+
+#endif //CG_PROJECT_MODELLOADER_H
@@ -0,0 +1,43 @@
+#ifndef CG_PROJECT_PACKEDVERTEX_H
+#define CG_PROJECT_PACKEDVERTEX_H
+
+#include <glm/glm.hpp>
+#include <cstdint>
+
+#include "rg/Frustum.h"
+
+namespace rg {
+
+    struct Vertex;
+
+    // layout of a mesh's vertex buffer, chosen per model when it is loaded
+    enum VertexFormat {
+        // rg::Vertex as imported, 56 bytes
+        VERTEX_FULL,
+        // rg::PackedVertex, 20 bytes, drawn with the *Packed.vs shaders
+        VERTEX_PACKED
+    };
+
+    // position as unorm16 inside the cube around the mesh bounds, w is the bitangent sign (0 for -1);
+    // normal and tangent octahedral snorm16, bitangent = cross(normal, tangent) * sign; half float uv
+    struct PackedVertex {
+        std::uint16_t Position[4];
+        std::int16_t Normal[2];
+        std::int16_t Tangent[2];
+        std::uint16_t TexCoords[2];
+    };
+
+    // side of the quantization cube, the largest extent of the bounds
+    float packedPositionScale(const AABB &bounds);
+    // takes a packed position back to model space; uniform scale, so it can go into a model
+    // matrix without bending the normals it transforms
+    glm::mat4 packedPositionDecode(const AABB &bounds);
+    PackedVertex packVertex(const Vertex &vertex, const AABB &bounds);
+
+    // round to nearest, overflow goes to infinity and tiny values to subnormals or zero
+    std::uint16_t floatToHalf(float value);
+    // unit vector to [-1, 1]^2, the same mapping as the G-buffer normals
+    glm::vec2 octEncode(const glm::vec3 &n);
+}
+
+#endif //CG_PROJECT_PACKEDVERTEX_H
@@ -0,0 +1,117 @@
+#ifndef CG_PROJECT_PROFILER_H
+#define CG_PROJECT_PROFILER_H
+
+#include <glad/glad.h>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace rg {
+
+    // nested CPU scopes, each optionally timed on the GPU with a GL_TIME_ELAPSED query.
+    // queries of frame n are polled at the start of frame n + FRAMES, when their slot is reused; a scope whose
+    // result still isn't available keeps the GPU time it had before instead of waiting for the driver.
+    // GL_TIME_ELAPSED queries can't nest: inside a GPU timed scope the inner scopes are CPU only.
+    // scope names have to outlive the profiler, string literals
+    class Profiler {
+    public:
+        static const unsigned int HISTORY = 120;
+        // frames of queries in flight
+        static const unsigned int FRAMES = 4;
+
+        // one named scope, summed over every time it was entered during a frame
+        struct Timing {
+            const char *name;
+            unsigned int depth;
+            double cpuMs;
+            // negative for CPU only scopes
+            double gpuMs;
+        };
+
+        // rolling per-name history of the resolved frames, oldest first
+        struct Track {
+            const char *name;
+            std::deque<float> cpuMs;
+            std::deque<float> gpuMs;
+        };
+
+    private:
+        struct Sample {
+            const char *name;
+            unsigned int depth;
+            double start;
+            double cpuMs;
+            int query;
+            double gpuMs;
+        };
+
+        struct Frame {
+            std::vector<Sample> samples;
+            std::vector<unsigned int> queries;
+            unsigned int usedQueries = 0;
+            double start = 0.0;
+            bool recorded = false;
+        };
+
+        Frame m_Frames[FRAMES];
+        unsigned int m_Current = 0;
+        std::vector<unsigned int> m_Stack;
+        int m_OpenQuery = -1;
+        std::chrono::steady_clock::time_point m_Epoch;
+
+        std::vector<Timing> m_Timings;
+        std::vector<Track> m_Tracks;
+        // resolved frames kept for the trace export
+        std::deque<std::vector<Sample>> m_TraceFrames;
+        unsigned int m_TraceCapacity;
+
+        double now() const;
+        void resolve(Frame &frame);
+        Track &track(const char *name);
+
+    public:
+        // traceFrames is the number of most recent frames writeChromeTrace() can export
+        explicit Profiler(unsigned int traceFrames = 300);
+
+        void beginFrame();
+        // closes scopes left open
+        void endFrame();
+
+        void begin(const char *name, bool gpu = true);
+        void end();
+
+        // timings of the most recently resolved frame, in the order the scopes were first entered
+        const std::vector<Timing> &getTimings() const;
+        const std::vector<Track> &getTracks() const;
+
+        // Chrome trace event JSON (chrome://tracing, ui.perfetto.dev), CPU scopes on thread 0 and
+        // GPU scopes on thread 1; GPU scopes only have a duration, they are placed at their CPU start
+        bool writeChromeTrace(const std::string &path) const;
+
+        // ImGui window with the last frame's timings and a rolling stacked bar chart of the GPU time per scope
+        void drawOverlay();
+
+        void free();
+    };
+
+    // begins on construction, ends on destruction
+    class ProfileScope {
+    private:
+        Profiler &m_Profiler;
+
+    public:
+        ProfileScope(Profiler &profiler, const char *name, bool gpu = true)
+                : m_Profiler(profiler) {
+            m_Profiler.begin(name, gpu);
+        }
+
+        ~ProfileScope() {
+            m_Profiler.end();
+        }
+    };
+
+}
+
+#endif //CG_PROJECT_PROFILER_H
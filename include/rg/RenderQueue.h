@@ -0,0 +1,119 @@
+#ifndef CG_PROJECT_RENDERQUEUE_H
+#define CG_PROJECT_RENDERQUEUE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "rg/Shader.h"
+
+namespace rg {
+
+    class Profiler;
+
+    const unsigned int MAX_DRAW_TEXTURES = 4;
+    // per-draw index of a multi-draw, an integer attribute after the vertex attributes and the instance matrix
+    const unsigned int DRAW_INDEX_LOCATION = 7;
+
+    // the layout glDrawElementsIndirect reads
+    struct DrawElementsIndirectCommand {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+    enum RenderPass {
+        // depth only copies of the opaque draws, laid down before the opaque pass
+        PASS_DEPTH = 0,
+        PASS_OPAQUE = 1,
+        // drawn after the opaque pass, back to front
+        PASS_TRANSPARENT = 2
+    };
+
+    // one draw call together with all the state it needs,
+    // textures[i] is bound to unit i
+    struct DrawItem {
+        unsigned int program = 0;
+        unsigned int vao = 0;
+        GLenum mode = GL_TRIANGLES;
+        GLsizei count = 0;
+        // glDrawElements with indices of indexType, otherwise glDrawArrays
+        bool indexed = true;
+        GLenum indexType = GL_UNSIGNED_INT;
+        GLsizei instanceCount = 1;
+
+        // with drawCount > 0 the item is commands firstCommand to firstCommand + drawCount instead of count indices,
+        // all from vao with indexType. with an indirectBuffer the GPU reads them from there in one
+        // glMultiDrawElementsIndirect, or glDrawElementsIndirect for a single one; otherwise they are taken from
+        // commands, one glDrawElementsBaseVertex each with DRAW_INDEX_LOCATION set to the command's baseInstance
+        // and commands with no instances skipped
+        const DrawElementsIndirectCommand *commands = nullptr;
+        GLsizei firstCommand = 0;
+        GLsizei drawCount = 0;
+        unsigned int indirectBuffer = 0;
+
+        unsigned int textures[MAX_DRAW_TEXTURES] = {};
+        unsigned int textureCount = 0;
+
+        GLenum cullFace = GL_BACK;
+        GLenum frontFace = GL_CCW;
+
+        Uniform<glm::mat4> modelUniform;
+        glm::mat4 model = glm::mat4(1.0f);
+
+        // profiler scope the draw is timed under, a string literal
+        const char *scope = nullptr;
+    };
+
+    // collects the draws of a frame, orders them by a 64-bit key and issues them through GLState,
+    // so program, texture, VAO and raster state changes that are already in place are skipped
+    class RenderQueue {
+    public:
+        struct Stats {
+            unsigned int draws = 0;
+            unsigned int binds = 0;
+            unsigned int skippedBinds = 0;
+        };
+
+    private:
+        struct SortEntry {
+            std::uint64_t key;
+            std::uint32_t index;
+        };
+
+        std::vector<DrawItem> m_Items;
+        std::vector<SortEntry> m_Order;
+        std::vector<SortEntry> m_Scratch;
+        // sorted once after the last submit, however many passes are drawn
+        bool m_Sorted = false;
+        Stats m_Stats;
+
+        void sort();
+        void count(bool forwarded);
+        void draw(std::size_t begin, std::size_t end, Profiler *profiler);
+        void multiDraw(const DrawItem &item);
+
+    public:
+        // depth is the distance to the camera mapped to [0, 1]
+        void submit(const DrawItem &item, RenderPass pass, float depth);
+        // sorts and draws everything submitted since the last clear(); with a profiler every run of
+        // consecutive items with the same scope is timed as that scope
+        void execute(Profiler *profiler = nullptr);
+        // draws only the items of one pass, so other work can go in between the passes
+        void execute(RenderPass pass, Profiler *profiler = nullptr);
+        void clear();
+
+        // counters of everything drawn since the last submit()
+        const Stats &getStats() const;
+        unsigned int size() const;
+
+        // pass | program | material | vao | depth, transparent items put depth right after the pass
+        static std::uint64_t makeKey(const DrawItem &item, RenderPass pass, float depth);
+    };
+
+}
+
+#endif //CG_PROJECT_RENDERQUEUE_H
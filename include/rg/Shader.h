@@ -6,9 +6,11 @@
 #define CG_PROJECT_SHADER_H
 
 #include <string>
+#include <vector>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <cstdint>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
@@ -18,15 +20,78 @@
 
 namespace rg {
 
+    inline void setUniform(int location, bool value) { glUniform1i(location, (int) value); }
+    inline void setUniform(int location, int value) { glUniform1i(location, value); }
+    inline void setUniform(int location, float value) { glUniform1f(location, value); }
+    inline void setUniform(int location, const glm::vec2 &value) { glUniform2fv(location, 1, &value[0]); }
+    inline void setUniform(int location, const glm::vec3 &value) { glUniform3fv(location, 1, &value[0]); }
+    inline void setUniform(int location, const glm::vec4 &value) { glUniform4fv(location, 1, &value[0]); }
+    inline void setUniform(int location, const glm::mat2 &mat) { glUniformMatrix2fv(location, 1, GL_FALSE, &mat[0][0]); }
+    inline void setUniform(int location, const glm::mat3 &mat) { glUniformMatrix3fv(location, 1, GL_FALSE, &mat[0][0]); }
+    inline void setUniform(int location, const glm::mat4 &mat) { glUniformMatrix4fv(location, 1, GL_FALSE, &mat[0][0]); }
+
+    // pre-resolved uniform location, setting it costs a single glUniform* call
+    // the owning program has to be in use, same as for Shader::set*
+    template<typename T>
+    class Uniform {
+    private:
+        int m_Location = -1;
+
+    public:
+        Uniform() = default;
+        explicit Uniform(int location) : m_Location(location) {}
+
+        void set(const T &value) const { setUniform(m_Location, value); }
+        int location() const { return m_Location; }
+        bool isActive() const { return m_Location != -1; }
+    };
+
     class Shader {
     private:
+        struct UniformSlot {
+            std::uint32_t hash = 0;
+            int location = -1;
+            std::string name;
+        };
+
         unsigned int m_Id;
+        bool m_Linked = false;
+        // open addressing table of all active uniforms, filled once after link
+        std::vector<UniformSlot> m_Uniforms;
+
+        static unsigned int s_Lookups;
+        static unsigned int s_LookupsLastFrame;
+
+        void reflectUniforms();
+        void insertUniform(const std::string &name, int location);
+
     public:
         Shader(std::string vertexShaderPath, std::string fragmentShaderPath);
+        // compute program, needs GLExtensions::hasCompute()
+        explicit Shader(std::string computeShaderPath);
 
         ~Shader();
         // activate the shader
         void use();
+        unsigned int getId() const;
+        // false if compiling or linking failed, the errors are already printed
+        bool isLinked() const;
+
+        // name -> location through the reflected table, never calls into the driver
+        int getUniformLocation(const std::string &name) const;
+
+        template<typename T>
+        Uniform<T> uniform(const std::string &name) const {
+            return Uniform<T>(getUniformLocation(name));
+        }
+
+        // number of by-name uniform lookups done since the last endFrame()
+        static unsigned int lookupsThisFrame();
+        static unsigned int lookupsLastFrame();
+        static void endFrame();
+
+        // attaches a uniform block of this program to a UniformBuffer binding point
+        void bindUniformBlock(const std::string &blockName, unsigned int binding) const;
 
         // utility uniform functions
         void setBool(const std::string &name, bool value) const;
@@ -57,4 +122,4 @@ namespace rg {
     };
 }
 
-#endif //CG_PROJECT_SHADER_H
\ No newline at end of file
+#endif //CG_PROJECT_SHADER_H
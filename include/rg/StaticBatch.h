@@ -0,0 +1,122 @@
+#ifndef CG_PROJECT_STATICBATCH_H
+#define CG_PROJECT_STATICBATCH_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "rg/Model.h"
+#include "rg/RenderQueue.h"
+#include "rg/TextureBuffer.h"
+
+namespace rg {
+
+    // merged geometry: the meshes of several models copied into one vertex buffer, one index buffer and one VAO,
+    // each placed object drawn as one command per mesh. commands are grouped by material, so a frame is one
+    // multi-draw per texture set (GL 4.3) or a loop of glDrawElementsBaseVertex without any rebinding (GL 3.3).
+    // the model matrix of every command, position decode included, is in a RGBA32F buffer texture on
+    // MATRIX_TEXTURE_UNIT, four texels per draw; the ModelBatch*.vs shaders fetch it with the draw index
+    // that comes in at DRAW_INDEX_LOCATION
+    class StaticBatch {
+    public:
+        typedef unsigned int ObjectId;
+        static const ObjectId INVALID_OBJECT = 0xffffffffu;
+        // after the three of rg::ClusteredLighting
+        static const unsigned int MATRIX_TEXTURE_UNIT = 11;
+
+    private:
+        // where one mesh ended up in the shared buffers
+        struct MeshRange {
+            GLuint firstIndex;
+            GLuint indexCount;
+            GLint baseVertex;
+            glm::mat4 positionDecode;
+            AABB bounds;
+            unsigned int textures[MAX_DRAW_TEXTURES];
+            unsigned int textureCount;
+        };
+
+        struct PackedModel {
+            const Model *model;
+            unsigned int firstMesh;
+            unsigned int meshCount;
+        };
+
+        struct Object {
+            unsigned int model;
+            glm::mat4 matrix;
+        };
+
+        struct Draw {
+            unsigned int object;
+            unsigned int mesh;
+        };
+
+        // a run of commands with the same textures
+        struct Group {
+            GLsizei firstCommand;
+            GLsizei drawCount;
+            unsigned int textures[MAX_DRAW_TEXTURES];
+            unsigned int textureCount;
+        };
+
+        VertexFormat m_Format;
+        std::size_t m_VertexSize;
+        // at least GL_UNSIGNED_SHORT, widened when a mesh with more vertices comes in
+        GLenum m_IndexType = GL_UNSIGNED_SHORT;
+        bool m_Indirect;
+
+        std::vector<MeshRange> m_Meshes;
+        std::vector<PackedModel> m_Models;
+        std::vector<Object> m_Objects;
+        // m_Draws, m_Commands and m_DrawMatrices are parallel and ordered by group
+        std::vector<Draw> m_Draws;
+        std::vector<DrawElementsIndirectCommand> m_Commands;
+        std::vector<glm::mat4> m_DrawMatrices;
+        std::vector<Group> m_Groups;
+
+        unsigned int m_VAO = 0;
+        unsigned int m_VertexBuffer = 0;
+        unsigned int m_IndexBuffer = 0;
+        std::size_t m_VertexCount = 0;
+        std::size_t m_VertexCapacity = 0;
+        std::size_t m_IndexCount = 0;
+        std::size_t m_IndexCapacity = 0;
+        // 0, 1, 2, ... read with divisor 1, so an instanced attribute starting at baseInstance is the draw index
+        unsigned int m_DrawIndexBuffer = 0;
+        unsigned int m_IndirectBuffer = 0;
+        TextureBuffer m_Matrices;
+
+        unsigned int packModel(const Model &model);
+        void reserveVertices(std::size_t count);
+        void reserveIndices(std::size_t count, GLenum indexType);
+        void setupVertexArray();
+        void buildDraws();
+
+    public:
+        // format has to be the one the added models were loaded with;
+        // indirect = false always draws through the GL 3.3 loop
+        explicit StaticBatch(VertexFormat format, bool indirect = true);
+
+        // places model, which has to be ready, at matrix; a model already in the batch is not copied again
+        ObjectId add(const Model &model, const glm::mat4 &matrix);
+        void setMatrix(ObjectId object, const glm::mat4 &matrix);
+
+        // once per frame before Submit: uploads the draw matrices, leaves out meshes outside of frustum
+        // if there is one, and binds the matrices to MATRIX_TEXTURE_UNIT
+        void prepare(const Frustum *frustum);
+        // one item per group, textures from the group unless item has its own;
+        // PASS_DEPTH is a single item with every command and no textures
+        void Submit(RenderQueue &queue, const DrawItem &item, RenderPass pass, float depth) const;
+
+        unsigned int getDrawCount() const;
+        unsigned int getGroupCount() const;
+        bool isIndirect() const;
+        std::size_t getVertexBufferSize() const;
+        std::size_t getIndexBufferSize() const;
+        void free();
+    };
+
+}
+
+#endif //CG_PROJECT_STATICBATCH_H
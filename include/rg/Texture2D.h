@@ -8,6 +8,7 @@
 #include <glad/glad.h>
 #include <stb_image.h>
 #include <iostream>
+#include "rg/TextureLoader.h"
 
 namespace rg {
 
@@ -17,7 +18,8 @@ namespace rg {
         unsigned int loadTexture(std::string path);
 
     public:
-        Texture2D(std::string path);
+        // with a textureLoader the image is decoded in the background and usable after its finish()
+        Texture2D(std::string path, TextureLoader *textureLoader = nullptr);
         unsigned int getId();
     };
 
@@ -0,0 +1,27 @@
+#ifndef CG_PROJECT_TEXTUREBUFFER_H
+#define CG_PROJECT_TEXTUREBUFFER_H
+
+#include <glad/glad.h>
+#include <cstddef>
+
+namespace rg {
+
+    // a buffer object seen by the shaders as a samplerBuffer / usamplerBuffer of format texels,
+    // refilled whole every time it changes
+    class TextureBuffer {
+    private:
+        unsigned int m_Buffer;
+        unsigned int m_Texture;
+
+    public:
+        // format is the internal format of the texels, GL_RGBA32F, GL_R32UI, ...
+        explicit TextureBuffer(GLenum format);
+        // replaces the contents with size bytes of data, size can be zero
+        void upload(const void *data, std::size_t size);
+        void bind(unsigned int unit) const;
+        void free();
+    };
+
+}
+
+#endif //CG_PROJECT_TEXTUREBUFFER_H
@@ -0,0 +1,70 @@
+#ifndef CG_PROJECT_TEXTURELOADER_H
+#define CG_PROJECT_TEXTURELOADER_H
+
+#include <glad/glad.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+
+#include "rg/ThreadPool.h"
+
+namespace rg {
+
+    // decoded pixels, owned by whoever called decodeImage
+    struct Image {
+        unsigned char *data = nullptr;
+        int width = 0;
+        int height = 0;
+        int channels = 0;
+    };
+
+    Image decodeImage(const std::string &path);
+    void freeImage(Image &image);
+    // glTexImage2D + mipmaps into an already generated texture, must run on the context thread;
+    // clampTransparent uses GL_CLAMP_TO_EDGE for RGBA images so their borders don't bleed
+    void uploadImage(unsigned int texture, const Image &image, bool clampTransparent);
+
+    // decodes images on a ThreadPool while the context thread does other work,
+    // texture ids are valid right away, their contents once finish() returns
+    class TextureLoader {
+    private:
+        struct Request {
+            unsigned int texture;
+            std::string path;
+            bool clampTransparent;
+            bool decoded = false;
+            Image image;
+        };
+
+        ThreadPool &m_Pool;
+        std::deque<Request> m_Requests;
+        std::mutex m_Mutex;
+        std::condition_variable m_Decoded;
+        std::size_t m_RequestCount = 0;
+        std::size_t m_UploadCount = 0;
+
+        void uploadFront(std::unique_lock<std::mutex> &lock);
+
+    public:
+        explicit TextureLoader(ThreadPool &pool);
+        TextureLoader(const TextureLoader &) = delete;
+        TextureLoader &operator=(const TextureLoader &) = delete;
+        ~TextureLoader();
+
+        unsigned int request(const std::string &path, bool clampTransparent = false);
+        // waits for the outstanding decodes and uploads them, in request order
+        void finish();
+        // uploads decoded images in request order until the deadline passes or the next one isn't decoded yet,
+        // never blocks; returns true once nothing is pending
+        bool update(std::chrono::steady_clock::time_point deadline);
+
+        // uploads happen in request order, so request number n is on the GPU once getUploadCount() >= n
+        std::size_t getRequestCount() const;
+        std::size_t getUploadCount() const;
+    };
+
+}
+
+#endif //CG_PROJECT_TEXTURELOADER_H
@@ -0,0 +1,41 @@
+#ifndef CG_PROJECT_THREADPOOL_H
+#define CG_PROJECT_THREADPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rg {
+
+    // fixed set of worker threads for CPU-only work, tasks must never touch GL
+    class ThreadPool {
+    private:
+        std::vector<std::thread> m_Workers;
+        std::deque<std::function<void()>> m_Tasks;
+        std::mutex m_Mutex;
+        std::condition_variable m_TaskAvailable;
+        std::condition_variable m_Idle;
+        unsigned int m_Running = 0;
+        bool m_Stopping = false;
+
+        void workerLoop();
+
+    public:
+        // 0 picks one worker per hardware thread
+        explicit ThreadPool(unsigned int threadCount = 0);
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+        ~ThreadPool();
+
+        void submit(std::function<void()> task);
+        // blocks until the queue is empty and no task is running
+        void wait();
+        unsigned int getThreadCount() const;
+    };
+
+}
+
+#endif //CG_PROJECT_THREADPOOL_H
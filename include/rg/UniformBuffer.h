@@ -0,0 +1,26 @@
+#ifndef CG_PROJECT_UNIFORMBUFFER_H
+#define CG_PROJECT_UNIFORMBUFFER_H
+
+#include <glad/glad.h>
+#include <cstddef>
+
+namespace rg {
+
+    // uniform buffer object attached to a fixed binding point, every program that
+    // binds a block to the same point (Shader::bindUniformBlock) reads the same data
+    class UniformBuffer {
+    private:
+        unsigned int m_Id;
+        unsigned int m_Binding;
+        std::size_t m_Size;
+
+    public:
+        UniformBuffer(std::size_t size, unsigned int binding);
+        void update(const void *data, std::size_t size, std::size_t offset = 0);
+        unsigned int getBinding() const;
+        void free();
+    };
+
+}
+
+#endif //CG_PROJECT_UNIFORMBUFFER_H
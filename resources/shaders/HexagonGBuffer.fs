@@ -0,0 +1,53 @@
+#version 330 core
+layout (location = 0) out vec4 gAlbedo;
+layout (location = 1) out vec2 gNormal;
+layout (location = 2) out vec4 gSpecular;
+
+struct Material {
+    sampler2D diffuseMap;
+    sampler2D normalMap;
+    sampler2D depthMap;
+    float shininess;
+};
+
+in VS_OUT {
+    vec3 FragPos;
+    vec2 TextureCoord;
+    vec3 TangentViewPos;
+    vec3 TangentFragPos;
+    mat3 TBN;
+} fs_in;
+
+uniform Material material;
+
+uniform float heightScale;
+
+vec2 ParallaxMapping(vec2 texCoords, vec3 viewDir) {
+    float height = texture(material.depthMap, texCoords).r;
+    return texCoords - viewDir.xy * (height * heightScale);
+}
+
+// octahedral mapping of a unit vector to [-1, 1]^2
+vec2 encodeNormal(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return n.xy;
+}
+
+void main() {
+    vec3 viewDir = normalize(fs_in.TangentViewPos - fs_in.TangentFragPos);
+    vec2 texCoords = ParallaxMapping(fs_in.TextureCoord, viewDir);
+    if(texCoords.x > 1.0 || texCoords.y > 1.0 || texCoords.x < 0.0 || texCoords.y < 0.0)
+        discard;
+
+    vec3 normal = texture(material.normalMap, texCoords).rgb;
+    normal = normalize(normal * 2.0 - 1.0);
+    vec3 color = texture(material.diffuseMap, fs_in.TextureCoord).rgb;
+
+    // the lighting pass works in world space, TBN goes the other way
+    gAlbedo = vec4(color, 1.0);
+    gNormal = encodeNormal(normalize(transpose(fs_in.TBN) * normal));
+    // the stone reflects its own color
+    gSpecular = vec4(color, material.shininess / 256.0);
+}
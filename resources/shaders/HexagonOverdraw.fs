@@ -0,0 +1,38 @@
+#version 330 core
+layout (location = 0) out vec4 FragColor;
+layout (location = 1) out vec4 BrightColor;
+
+// overdraw.fs with the parallax discard of HexagonShader.fs, so only the fragments the colour pass shades are counted
+
+struct Material {
+    sampler2D diffuseMap;
+    sampler2D normalMap;
+    sampler2D depthMap;
+    float shininess;
+};
+
+in VS_OUT {
+    vec3 FragPos;
+    vec2 TextureCoord;
+    vec3 TangentViewPos;
+    vec3 TangentFragPos;
+    mat3 TBN;
+} fs_in;
+
+uniform Material material;
+
+uniform float heightScale;
+
+vec2 ParallaxMapping(vec2 texCoords, vec3 viewDir) {
+    float height = texture(material.depthMap, texCoords).r;
+    return texCoords - viewDir.xy * (height * heightScale);
+}
+
+void main() {
+    vec3 viewDir = normalize(fs_in.TangentViewPos - fs_in.TangentFragPos);
+    vec2 texCoords = ParallaxMapping(fs_in.TextureCoord, viewDir);
+    if(texCoords.x > 1.0 || texCoords.y > 1.0 || texCoords.x < 0.0 || texCoords.y < 0.0)
+        discard;
+    FragColor = vec4(1.0, 0.0, 0.0, 0.0);
+    BrightColor = vec4(0.0);
+}
@@ -12,7 +12,7 @@ struct DirLight {
 
 struct PointLight {
     vec3 position;
-    vec3 color;
+    float radius;
 
     vec3 ambient;
     vec3 diffuse;
@@ -23,6 +23,50 @@ struct PointLight {
     float quadratic;
 };
 
+layout (std140) uniform LightingBlock {
+    DirLight dirLight;
+    // tiles across, tiles down, depth slices
+    uvec4 clusterGrid;
+    // tile size in pixels, near plane, depth slices / log(far / near)
+    vec4 clusterParams;
+};
+
+layout (std140) uniform CameraBlock {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
+
+// point lights and their assignment to clusters, laid out as described in rg::ClusteredLighting
+uniform samplerBuffer pointLights;
+uniform usamplerBuffer clusterLights;
+uniform usamplerBuffer lightIndices;
+
+PointLight fetchPointLight(int index) {
+    PointLight light;
+    vec4 texel = texelFetch(pointLights, 4 * index);
+    light.position = texel.xyz;
+    light.radius = texel.w;
+    texel = texelFetch(pointLights, 4 * index + 1);
+    light.ambient = texel.xyz;
+    light.constant = texel.w;
+    texel = texelFetch(pointLights, 4 * index + 2);
+    light.diffuse = texel.xyz;
+    light.linear = texel.w;
+    texel = texelFetch(pointLights, 4 * index + 3);
+    light.specular = texel.xyz;
+    light.quadratic = texel.w;
+    return light;
+}
+
+// offset into lightIndices and light count of the cluster the fragment falls in
+uvec2 fetchCluster(vec3 fragPos) {
+    float depth = -(view * vec4(fragPos, 1.0)).z;
+    uint slice = uint(clamp(log(depth / clusterParams.z) * clusterParams.w, 0.0, float(clusterGrid.z - 1u)));
+    uvec2 tile = min(uvec2(gl_FragCoord.xy / clusterParams.xy), clusterGrid.xy - 1u);
+    return texelFetch(clusterLights, int(tile.x + clusterGrid.x * (tile.y + clusterGrid.y * slice))).xy;
+}
+
 struct Material {
     sampler2D diffuseMap;
     sampler2D normalMap;
@@ -30,20 +74,15 @@ struct Material {
     float shininess;
 };
 
-#define POINT_LIGHT_NUMBER 3
-
 in VS_OUT {
     vec3 FragPos;
     vec2 TextureCoord;
-    vec3 TangentLightPos;
     vec3 TangentViewPos;
     vec3 TangentFragPos;
+    mat3 TBN;
 } fs_in;
 
-uniform vec3 viewPos;
 uniform Material material;
-uniform DirLight dirLight;
-uniform PointLight pointLight[POINT_LIGHT_NUMBER];
 
 uniform float heightScale;
 
@@ -76,24 +115,30 @@ void main() {
     vec3 specular = dirLight.specular * spec * color;
     vec3 result = ambient + diffuse + specular;
 
-    for (int i = 0; i < POINT_LIGHT_NUMBER; i++) {
+    // only the lights whose range reaches the fragment's cluster
+    uvec2 cluster = fetchCluster(fs_in.FragPos);
+    for (uint i = 0u; i < cluster.y; i++) {
+        PointLight pointLight = fetchPointLight(int(texelFetch(lightIndices, int(cluster.x + i)).r));
+        float distance = length(pointLight.position - fs_in.FragPos);
+        if (distance >= pointLight.radius)
+            continue;
+
         // point light
         // ambient
-        ambient = pointLight[i].ambient * color;
+        ambient = pointLight.ambient * color;
 
         // diffuse
-        lightDir = normalize(fs_in.TangentLightPos - fs_in.TangentFragPos);
+        lightDir = normalize(fs_in.TBN * pointLight.position - fs_in.TangentFragPos);
         diff = max(dot(lightDir, normal), 0.0);
-        diffuse = pointLight[i].color * pointLight[i].diffuse * diff * color;
+        diffuse = pointLight.diffuse * diff * color;
 
         // specular
         vec3 halfwayDir = normalize(lightDir + viewDir);
         spec = pow(max(dot(normal, halfwayDir), 0.0), material.shininess);
-        specular = pointLight[i].specular * spec * color;
+        specular = pointLight.specular * spec * color;
 
         // attenuation
-        float distance = length(pointLight[i].position - fs_in.FragPos);
-        float attenuation = 1.0 / (pointLight[i].constant + pointLight[i].linear * distance + pointLight[i].quadratic * (distance * distance));
+        float attenuation = 1.0 / (pointLight.constant + pointLight.linear * distance + pointLight.quadratic * (distance * distance));
 
         ambient *= attenuation;
         diffuse *= attenuation;
@@ -8,17 +8,22 @@ layout (location = 4) in vec3 aBitangent;
 out VS_OUT {
     vec3 FragPos;
     vec2 TextureCoord;
-    vec3 TangentLightPos;
     vec3 TangentViewPos;
     vec3 TangentFragPos;
+    // world to tangent space, the fragment shader moves each of its lights with it
+    mat3 TBN;
 } vs_out;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 
-uniform vec3 viewPos;
-uniform vec3 lightPos;
+layout (std140) uniform CameraBlock {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
+
+// the depth pre-pass runs this same shader with HexagonDepth.fs
+invariant gl_Position;
 
 void main() {
     vs_out.FragPos = vec3(model * vec4(aPos, 1.0));
@@ -29,9 +34,9 @@ void main() {
     vec3 N = normalize(mat3(model) * aNormal);
     mat3 TBN = transpose(mat3(T, B, N));
 
-    vs_out.TangentLightPos = TBN * lightPos;
     vs_out.TangentViewPos = TBN * viewPos;
     vs_out.TangentFragPos = TBN * vs_out.FragPos;
+    vs_out.TBN = TBN;
 
     gl_Position = projection * view * model * vec4(aPos, 1.0);
 }
\ No newline at end of file
@@ -8,8 +8,14 @@ out vec2 TexCoords;
 out vec3 Normal;
 out vec3 FragPos;
 
-uniform mat4 view;
-uniform mat4 projection;
+layout (std140) uniform CameraBlock {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
+
+// matched exactly by InstanceModelDepth.vs for the depth pre-pass
+invariant gl_Position;
 
 void main()
 {
@@ -0,0 +1,20 @@
+#version 330 core
+layout (location = 0) in vec4 aPos;
+layout (location = 3) in mat4 aInstancedMatrix;
+
+uniform mat4 model;
+
+layout (std140) uniform CameraBlock {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
+
+// computed exactly as in InstanceModelPacked.vs
+invariant gl_Position;
+
+void main()
+{
+    vec3 FragPos = vec3(aInstancedMatrix * (model * vec4(aPos.xyz, 1.0)));
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
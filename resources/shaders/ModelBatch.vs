@@ -0,0 +1,36 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+// index of the draw within rg::StaticBatch, its model matrix is 4 texels of drawMatrices
+layout (location = 7) in uint aDrawIndex;
+
+out vec2 TexCoords;
+out vec3 Normal;
+out vec3 FragPos;
+
+uniform samplerBuffer drawMatrices;
+
+layout (std140) uniform CameraBlock {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
+
+mat4 fetchModel(uint index) {
+    int base = 4 * int(index);
+    return mat4(texelFetch(drawMatrices, base), texelFetch(drawMatrices, base + 1),
+                texelFetch(drawMatrices, base + 2), texelFetch(drawMatrices, base + 3));
+}
+
+// ModelBatchDepth.vs computes the same position for the depth pre-pass
+invariant gl_Position;
+
+void main()
+{
+    mat4 model = fetchModel(aDrawIndex);
+    FragPos = vec3(model * vec4(aPos, 1.0));
+    Normal = mat3(transpose(inverse(model))) * aNormal;
+    TexCoords = aTexCoords;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
@@ -0,0 +1,26 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 7) in uint aDrawIndex;
+
+uniform samplerBuffer drawMatrices;
+
+layout (std140) uniform CameraBlock {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
+
+mat4 fetchModel(uint index) {
+    int base = 4 * int(index);
+    return mat4(texelFetch(drawMatrices, base), texelFetch(drawMatrices, base + 1),
+                texelFetch(drawMatrices, base + 2), texelFetch(drawMatrices, base + 3));
+}
+
+// the colour pass tests GL_EQUAL against this depth, the position has to come out bit for bit as in ModelBatch.vs
+invariant gl_Position;
+
+void main()
+{
+    vec3 FragPos = vec3(fetchModel(aDrawIndex) * vec4(aPos, 1.0));
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
@@ -0,0 +1,19 @@
+#version 330 core
+layout (location = 0) in vec4 aPos;
+
+uniform mat4 model;
+
+layout (std140) uniform CameraBlock {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
+
+// computed exactly as in ModelShaderPacked.vs
+invariant gl_Position;
+
+void main()
+{
+    vec3 FragPos = vec3(model * vec4(aPos.xyz, 1.0));
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
@@ -0,0 +1,31 @@
+#version 330 core
+layout (location = 0) out vec4 gAlbedo;
+layout (location = 1) out vec2 gNormal;
+layout (location = 2) out vec4 gSpecular;
+
+struct Material {
+    sampler2D diffuseMap;
+    sampler2D specularMap;
+    float shininess;
+};
+
+in vec2 TexCoords;
+in vec3 Normal;
+in vec3 FragPos;
+
+uniform Material material;
+
+// octahedral mapping of a unit vector to [-1, 1]^2
+vec2 encodeNormal(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return n.xy;
+}
+
+void main()
+{
+    gAlbedo = vec4(texture(material.diffuseMap, TexCoords).rgb, 1.0);
+    gNormal = encodeNormal(normalize(Normal));
+    gSpecular = vec4(texture(material.specularMap, TexCoords).rgb, material.shininess / 256.0);
+}
@@ -12,7 +12,7 @@ struct DirLight {
 
 struct PointLight {
     vec3 position;
-    vec3 color;
+    float radius;
 
     vec3 ambient;
     vec3 diffuse;
@@ -23,24 +23,62 @@ struct PointLight {
     float quadratic;
 };
 
+layout (std140) uniform LightingBlock {
+    DirLight dirLight;
+    // tiles across, tiles down, depth slices
+    uvec4 clusterGrid;
+    // tile size in pixels, near plane, depth slices / log(far / near)
+    vec4 clusterParams;
+};
+
+layout (std140) uniform CameraBlock {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
+
+// point lights and their assignment to clusters, laid out as described in rg::ClusteredLighting
+uniform samplerBuffer pointLights;
+uniform usamplerBuffer clusterLights;
+uniform usamplerBuffer lightIndices;
+
+PointLight fetchPointLight(int index) {
+    PointLight light;
+    vec4 texel = texelFetch(pointLights, 4 * index);
+    light.position = texel.xyz;
+    light.radius = texel.w;
+    texel = texelFetch(pointLights, 4 * index + 1);
+    light.ambient = texel.xyz;
+    light.constant = texel.w;
+    texel = texelFetch(pointLights, 4 * index + 2);
+    light.diffuse = texel.xyz;
+    light.linear = texel.w;
+    texel = texelFetch(pointLights, 4 * index + 3);
+    light.specular = texel.xyz;
+    light.quadratic = texel.w;
+    return light;
+}
+
+// offset into lightIndices and light count of the cluster the fragment falls in
+uvec2 fetchCluster(vec3 fragPos) {
+    float depth = -(view * vec4(fragPos, 1.0)).z;
+    uint slice = uint(clamp(log(depth / clusterParams.z) * clusterParams.w, 0.0, float(clusterGrid.z - 1u)));
+    uvec2 tile = min(uvec2(gl_FragCoord.xy / clusterParams.xy), clusterGrid.xy - 1u);
+    return texelFetch(clusterLights, int(tile.x + clusterGrid.x * (tile.y + clusterGrid.y * slice))).xy;
+}
+
 struct Material {
     sampler2D diffuseMap;
     sampler2D specularMap;
     float shininess;
 };
 
-#define POINT_LIGHT_NUMBER 3
-
 in vec2 TexCoords;
 in vec3 Normal;
 in vec3 FragPos;
 
-uniform DirLight dirLight;
-uniform PointLight pointLight[POINT_LIGHT_NUMBER];
 uniform Material material;
 
-uniform vec3 viewPosition;
-
 vec3 calcDirLight(DirLight light, vec3 normal, vec3 viewDir) {
     vec3 lightDir = normalize(-light.direction);
     // diffuse shading
@@ -62,7 +100,7 @@ vec3 calcPointLight(PointLight pointLight, vec3 normal, vec3 FragPos, vec3 viewD
     // diffuse
     vec3 lightDir = normalize(pointLight.position - FragPos);
     float diff = max(dot(normal, lightDir), 0.0);
-    vec3 diffuse = pointLight.color * pointLight.diffuse * diff * vec3(texture(material.diffuseMap, TexCoords).rgb);
+    vec3 diffuse = pointLight.diffuse * diff * vec3(texture(material.diffuseMap, TexCoords).rgb);
 
     // specular
     vec3 reflectDir = reflect(-lightDir, normal);
@@ -84,11 +122,16 @@ vec3 calcPointLight(PointLight pointLight, vec3 normal, vec3 FragPos, vec3 viewD
 void main()
 {
     vec3 normal = normalize(Normal);
-    vec3 viewDir = normalize(viewPosition - FragPos);
+    vec3 viewDir = normalize(viewPos - FragPos);
 
     vec3 result = calcDirLight(dirLight, normal, viewDir);
-    for (int i = 0; i < POINT_LIGHT_NUMBER; i++)
-        result += calcPointLight(pointLight[i], normal, FragPos, viewDir);
+    // only the lights whose range reaches the fragment's cluster
+    uvec2 cluster = fetchCluster(FragPos);
+    for (uint i = 0u; i < cluster.y; i++) {
+        PointLight pointLight = fetchPointLight(int(texelFetch(lightIndices, int(cluster.x + i)).r));
+        if (length(pointLight.position - FragPos) < pointLight.radius)
+            result += calcPointLight(pointLight, normal, FragPos, viewDir);
+    }
 
     float brightness = dot(result, vec3(0.2126, 0.7152, 0.0722));
     if(brightness > 1.0)
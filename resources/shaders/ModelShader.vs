@@ -8,8 +8,15 @@ out vec3 Normal;
 out vec3 FragPos;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+layout (std140) uniform CameraBlock {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
+
+// the depth pre-pass in ModelDepth.vs computes the same position, GL_EQUAL needs both to match exactly
+invariant gl_Position;
 
 void main()
 {
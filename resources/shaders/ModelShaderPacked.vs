@@ -0,0 +1,37 @@
+#version 330 core
+// rg::PackedVertex, the position decode is part of the model matrix
+layout (location = 0) in vec4 aPos;
+layout (location = 1) in vec2 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+
+out vec2 TexCoords;
+out vec3 Normal;
+out vec3 FragPos;
+
+uniform mat4 model;
+
+layout (std140) uniform CameraBlock {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
+
+// octahedral normal back to a unit vector, see rg::octEncode
+vec3 decodeNormal(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+
+// matched exactly by ModelDepthPacked.vs for the depth pre-pass
+invariant gl_Position;
+
+void main()
+{
+    FragPos = vec3(model * vec4(aPos.xyz, 1.0));
+    // the decode scale is uniform, it only changes the length
+    Normal = mat3(transpose(inverse(model))) * decodeNormal(aNormal);
+    TexCoords = aTexCoords;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
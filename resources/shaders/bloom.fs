@@ -6,22 +6,19 @@ in vec2 TexCoords;
 uniform sampler2D image;
 
 uniform bool horizontal;
-uniform float weight[5] = float[] (0.2270270270, 0.1945945946, 0.1216216216, 0.0540540541, 0.0162162162);
+// rg::GaussianKernel, every tap except the first is read on both sides of the center
+const int MAX_TAPS = 16;
+uniform int tapCount;
+uniform float offsets[MAX_TAPS];
+uniform float weights[MAX_TAPS];
 
 void main() {
      vec2 tex_offset = 1.0 / textureSize(image, 0);
-     vec3 result = texture(image, TexCoords).rgb * weight[0];
-     if(horizontal) {
-         for(int i = 1; i < 5; ++i) {
-            result += texture(image, TexCoords + vec2(tex_offset.x * i, 0.0)).rgb * weight[i];
-            result += texture(image, TexCoords - vec2(tex_offset.x * i, 0.0)).rgb * weight[i];
-         }
-     }
-     else {
-         for(int i = 1; i < 5; ++i) {
-             result += texture(image, TexCoords + vec2(0.0, tex_offset.y * i)).rgb * weight[i];
-             result += texture(image, TexCoords - vec2(0.0, tex_offset.y * i)).rgb * weight[i];
-         }
+     vec2 direction = horizontal ? vec2(tex_offset.x, 0.0) : vec2(0.0, tex_offset.y);
+     vec3 result = texture(image, TexCoords).rgb * weights[0];
+     for(int i = 1; i < tapCount; ++i) {
+         result += texture(image, TexCoords + direction * offsets[i]).rgb * weights[i];
+         result += texture(image, TexCoords - direction * offsets[i]).rgb * weights[i];
      }
      FragColor = vec4(result, 1.0);
-}
\ No newline at end of file
+}
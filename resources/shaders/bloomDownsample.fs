@@ -0,0 +1,58 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D image;
+// one texel of the source level
+uniform vec2 texelSize;
+uniform bool karisAverage;
+
+float karisWeight(vec3 color) {
+    float luma = dot(color, vec3(0.2126, 0.7152, 0.0722));
+    return 1.0 / (1.0 + luma);
+}
+
+// 13 bilinear taps covering a 6x6 texel area: one box in the center,
+// four overlapping boxes around it, each box 0.5 / 0.125 weighted (Jimenez, CoD: AW)
+void main() {
+    float x = texelSize.x;
+    float y = texelSize.y;
+
+    vec3 a = texture(image, TexCoords + vec2(-2.0 * x, 2.0 * y)).rgb;
+    vec3 b = texture(image, TexCoords + vec2(0.0, 2.0 * y)).rgb;
+    vec3 c = texture(image, TexCoords + vec2(2.0 * x, 2.0 * y)).rgb;
+
+    vec3 d = texture(image, TexCoords + vec2(-2.0 * x, 0.0)).rgb;
+    vec3 e = texture(image, TexCoords).rgb;
+    vec3 f = texture(image, TexCoords + vec2(2.0 * x, 0.0)).rgb;
+
+    vec3 g = texture(image, TexCoords + vec2(-2.0 * x, -2.0 * y)).rgb;
+    vec3 h = texture(image, TexCoords + vec2(0.0, -2.0 * y)).rgb;
+    vec3 i = texture(image, TexCoords + vec2(2.0 * x, -2.0 * y)).rgb;
+
+    vec3 j = texture(image, TexCoords + vec2(-x, y)).rgb;
+    vec3 k = texture(image, TexCoords + vec2(x, y)).rgb;
+    vec3 l = texture(image, TexCoords + vec2(-x, -y)).rgb;
+    vec3 m = texture(image, TexCoords + vec2(x, -y)).rgb;
+
+    vec3 center = (j + k + l + m) * 0.25;
+    vec3 topLeft = (a + b + d + e) * 0.25;
+    vec3 topRight = (b + c + e + f) * 0.25;
+    vec3 bottomLeft = (d + e + g + h) * 0.25;
+    vec3 bottomRight = (e + f + h + i) * 0.25;
+
+    vec3 result;
+    if (karisAverage) {
+        float wc = karisWeight(center) * 0.5;
+        float wtl = karisWeight(topLeft) * 0.125;
+        float wtr = karisWeight(topRight) * 0.125;
+        float wbl = karisWeight(bottomLeft) * 0.125;
+        float wbr = karisWeight(bottomRight) * 0.125;
+        result = (center * wc + topLeft * wtl + topRight * wtr + bottomLeft * wbl + bottomRight * wbr)
+                 / (wc + wtl + wtr + wbl + wbr);
+    } else {
+        result = center * 0.5 + (topLeft + topRight + bottomLeft + bottomRight) * 0.125;
+    }
+    FragColor = vec4(max(result, vec3(0.0)), 1.0);
+}
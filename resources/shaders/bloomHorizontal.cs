@@ -0,0 +1,35 @@
+#version 430 core
+// rows of TILE texels per workgroup, read once into shared memory together with
+// radius texels on each side, every thread then sums its neighbours from there
+const int TILE = 128;
+const int MAX_RADIUS = 30;
+layout (local_size_x = 128, local_size_y = 1) in;
+
+uniform sampler2D image;
+layout (r11f_g11f_b10f) uniform writeonly image2D result;
+
+// rg::GaussianKernel::discreteWeights
+uniform int radius;
+uniform float weights[MAX_RADIUS + 1];
+
+shared vec3 tile[TILE + 2 * MAX_RADIUS];
+
+void main() {
+    ivec2 size = textureSize(image, 0);
+    int y = int(gl_WorkGroupID.y);
+    int first = int(gl_WorkGroupID.x) * TILE - radius;
+    for (int i = int(gl_LocalInvocationID.x); i < TILE + 2 * radius; i += TILE) {
+        tile[i] = texelFetch(image, ivec2(clamp(first + i, 0, size.x - 1), y), 0).rgb;
+    }
+    barrier();
+
+    int x = int(gl_GlobalInvocationID.x);
+    if (x >= size.x)
+        return;
+    int center = int(gl_LocalInvocationID.x) + radius;
+    vec3 sum = tile[center] * weights[0];
+    for (int i = 1; i <= radius; ++i) {
+        sum += (tile[center - i] + tile[center + i]) * weights[i];
+    }
+    imageStore(result, ivec2(x, y), vec4(sum, 1.0));
+}
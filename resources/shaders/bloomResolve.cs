@@ -0,0 +1,52 @@
+#version 430 core
+// vertical half of the blur fused with the hdr.fs resolve: columns of TILE texels per workgroup
+// with a radius halo in shared memory, the blurred value is added to the hdr color and
+// tonemapped right away, so the bloom result never goes through memory
+const int TILE = 128;
+const int MAX_RADIUS = 30;
+layout (local_size_x = 1, local_size_y = 128) in;
+
+// horizontal blur of the bright buffer
+uniform sampler2D image;
+uniform sampler2D hdrBuffer;
+layout (rgba8) uniform writeonly image2D result;
+
+uniform int radius;
+uniform float weights[MAX_RADIUS + 1];
+uniform bool hdr;
+uniform bool bloom;
+uniform float exposure;
+
+shared vec3 tile[TILE + 2 * MAX_RADIUS];
+
+void main() {
+    ivec2 size = textureSize(hdrBuffer, 0);
+    int x = int(gl_WorkGroupID.x);
+    if (bloom) {
+        int first = int(gl_WorkGroupID.y) * TILE - radius;
+        for (int i = int(gl_LocalInvocationID.y); i < TILE + 2 * radius; i += TILE) {
+            tile[i] = texelFetch(image, ivec2(x, clamp(first + i, 0, size.y - 1)), 0).rgb;
+        }
+    }
+    barrier();
+
+    int y = int(gl_GlobalInvocationID.y);
+    if (y >= size.y)
+        return;
+    vec3 hdrColor = texelFetch(hdrBuffer, ivec2(x, y), 0).rgb;
+    if (bloom) {
+        int center = int(gl_LocalInvocationID.y) + radius;
+        vec3 sum = tile[center] * weights[0];
+        for (int i = 1; i <= radius; ++i) {
+            sum += (tile[center - i] + tile[center + i]) * weights[i];
+        }
+        hdrColor += sum;
+    }
+
+    const float gamma = 2.2;
+    vec3 color = hdrColor;
+    if (hdr)
+        color = vec3(1.0) - exp(-hdrColor * exposure);
+    color = pow(color, vec3(1.0 / gamma));
+    imageStore(result, ivec2(x, y), vec4(color, 1.0));
+}
@@ -0,0 +1,25 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D image;
+// tent filter spread in texture coordinates
+uniform vec2 radius;
+
+// 3x3 tent, added on top of the larger level by blending
+void main() {
+    float x = radius.x;
+    float y = radius.y;
+
+    vec3 result = texture(image, TexCoords).rgb * 4.0;
+    result += (texture(image, TexCoords + vec2(0.0, y)).rgb +
+               texture(image, TexCoords + vec2(-x, 0.0)).rgb +
+               texture(image, TexCoords + vec2(x, 0.0)).rgb +
+               texture(image, TexCoords + vec2(0.0, -y)).rgb) * 2.0;
+    result += texture(image, TexCoords + vec2(-x, y)).rgb +
+              texture(image, TexCoords + vec2(x, y)).rgb +
+              texture(image, TexCoords + vec2(-x, -y)).rgb +
+              texture(image, TexCoords + vec2(x, -y)).rgb;
+    FragColor = vec4(result / 16.0, 1.0);
+}
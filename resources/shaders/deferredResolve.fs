@@ -0,0 +1,71 @@
+#version 330 core
+layout (location = 0) out vec4 FragColor;
+layout (location = 1) out vec4 BrightColor;
+
+struct DirLight {
+    vec3 direction;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+layout (std140) uniform LightingBlock {
+    DirLight dirLight;
+    uvec4 clusterGrid;
+    vec4 clusterParams;
+};
+
+layout (std140) uniform CameraBlock {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
+
+in vec2 TexCoords;
+
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform sampler2D gSpecular;
+uniform sampler2D gDepth;
+// sum of the point light volumes
+uniform sampler2D pointLighting;
+uniform mat4 inverseViewProjection;
+
+vec3 decodeNormal(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+
+void main() {
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, texel, 0).r;
+    // nothing was drawn here, the clear color stays
+    if (depth == 1.0)
+        discard;
+
+    vec4 position = inverseViewProjection * vec4(TexCoords * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+    vec3 fragPos = position.xyz / position.w;
+
+    vec3 albedo = texelFetch(gAlbedo, texel, 0).rgb;
+    vec4 specularShininess = texelFetch(gSpecular, texel, 0);
+    vec3 normal = decodeNormal(texelFetch(gNormal, texel, 0).xy);
+    vec3 viewDir = normalize(viewPos - fragPos);
+
+    // same terms as calcDirLight of the forward shaders
+    vec3 lightDir = normalize(-dirLight.direction);
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), specularShininess.a * 256.0);
+    vec3 result = dirLight.ambient * albedo + dirLight.diffuse * diff * albedo + dirLight.specular * spec * specularShininess.rgb;
+    result += texelFetch(pointLighting, texel, 0).rgb;
+
+    float brightness = dot(result, vec3(0.2126, 0.7152, 0.0722));
+    if(brightness > 1.0)
+        BrightColor = vec4(result, 1.0);
+    else
+        BrightColor = vec4(0.0, 0.0, 0.0, 1.0);
+    FragColor = vec4(result, 1.0);
+}
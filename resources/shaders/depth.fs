@@ -0,0 +1,6 @@
+#version 330 core
+
+// colour writes are masked off, only the depth test and write run
+void main()
+{
+}
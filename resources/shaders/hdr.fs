@@ -7,6 +7,7 @@ uniform sampler2D hdrBuffer;
 uniform sampler2D bloomBlur;
 uniform bool hdr;
 uniform bool bloom;
+uniform float bloomStrength;
 uniform float exposure;
 
 void main() {
@@ -15,7 +16,7 @@ void main() {
     vec3 bloomColor = texture(bloomBlur, TexCoords).rgb;
 
     if (bloom)
-        hdrColor += bloomColor;
+        hdrColor += bloomColor * bloomStrength;
 
     vec3 result = hdrColor;
     if (hdr)
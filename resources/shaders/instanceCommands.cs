@@ -0,0 +1,25 @@
+#version 430 core
+// after instanceCull.cs: every mesh of the model draws the instances that survived
+layout (local_size_x = 64) in;
+
+// rg::DrawElementsIndirectCommand
+struct Command {
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+layout (std430, binding = 2) readonly buffer Counter {
+    uint visibleCount;
+};
+layout (std430, binding = 3) buffer Commands {
+    Command commands[];
+};
+
+void main() {
+    uint mesh = gl_GlobalInvocationID.x;
+    if (mesh < uint(commands.length()))
+        commands[mesh].instanceCount = visibleCount;
+}
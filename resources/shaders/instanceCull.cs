@@ -0,0 +1,50 @@
+#version 430 core
+// one invocation per instance of rg::InstancedModel: the model's bounding sphere, moved by the instance matrix,
+// is tested against the six frustum planes like rg::InstanceCuller does on the CPU, and the whole record of
+// every instance that survives is appended to culled
+// InstancedModel::CULL_GROUP_SIZE
+layout (local_size_x = 256) in;
+
+// stride floats per instance, the model matrix first and the streams after it
+layout (std430, binding = 0) readonly buffer Instances {
+    float instances[];
+};
+layout (std430, binding = 1) writeonly buffer Culled {
+    float culled[];
+};
+layout (std430, binding = 2) buffer Counter {
+    uint visibleCount;
+};
+
+uniform int instanceCount;
+uniform int stride;
+// model space center and radius
+uniform vec4 boundingSphere;
+// normalized and pointing inwards, see rg::Frustum
+uniform vec4 planes[6];
+
+void main() {
+    uint instance = gl_GlobalInvocationID.x;
+    if (instance >= uint(instanceCount))
+        return;
+
+    uint base = instance * uint(stride);
+    mat4 model;
+    for (uint column = 0u; column < 4u; column++) {
+        uint first = base + 4u * column;
+        model[column] = vec4(instances[first], instances[first + 1u], instances[first + 2u], instances[first + 3u]);
+    }
+    vec3 center = vec3(model * vec4(boundingSphere.xyz, 1.0));
+    float scale = max(length(model[0].xyz), max(length(model[1].xyz), length(model[2].xyz)));
+    float radius = boundingSphere.w * scale;
+    for (int p = 0; p < 6; p++) {
+        if (dot(planes[p].xyz, center) + planes[p].w < -radius)
+            return;
+    }
+
+    uint slot = atomicAdd(visibleCount, 1u);
+    uint target = slot * uint(stride);
+    for (uint i = 0u; i < uint(stride); i++) {
+        culled[target + i] = instances[base + i];
+    }
+}
@@ -0,0 +1,60 @@
+#version 330 core
+layout (location = 0) out vec4 FragColor;
+
+layout (std140) uniform CameraBlock {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
+
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform sampler2D gSpecular;
+uniform sampler2D gDepth;
+uniform mat4 inverseViewProjection;
+
+flat in vec4 LightPositionRadius;
+flat in vec4 LightAmbientConstant;
+flat in vec4 LightDiffuseLinear;
+flat in vec4 LightSpecularQuadratic;
+
+vec3 decodeNormal(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+
+void main() {
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, texel, 0).r;
+    if (depth == 1.0)
+        discard;
+
+    // world position of the surface behind the volume, from its depth
+    vec2 ndc = gl_FragCoord.xy / vec2(textureSize(gDepth, 0)) * 2.0 - 1.0;
+    vec4 position = inverseViewProjection * vec4(ndc, depth * 2.0 - 1.0, 1.0);
+    vec3 fragPos = position.xyz / position.w;
+
+    vec3 lightPosition = LightPositionRadius.xyz;
+    float distance = length(lightPosition - fragPos);
+    if (distance >= LightPositionRadius.w)
+        discard;
+
+    vec3 albedo = texelFetch(gAlbedo, texel, 0).rgb;
+    vec4 specularShininess = texelFetch(gSpecular, texel, 0);
+    vec3 normal = decodeNormal(texelFetch(gNormal, texel, 0).xy);
+    vec3 viewDir = normalize(viewPos - fragPos);
+
+    // same terms as calcPointLight of the forward shaders
+    vec3 ambient = LightAmbientConstant.rgb * albedo;
+    vec3 lightDir = normalize(lightPosition - fragPos);
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 diffuse = LightDiffuseLinear.rgb * diff * albedo;
+    vec3 halfwayDir = normalize(lightDir + viewDir);
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), specularShininess.a * 256.0);
+    vec3 specular = LightSpecularQuadratic.rgb * spec * specularShininess.rgb;
+
+    float attenuation = 1.0 / (LightAmbientConstant.w + LightDiffuseLinear.w * distance + LightSpecularQuadratic.w * (distance * distance));
+    FragColor = vec4((ambient + diffuse + specular) * attenuation, 1.0);
+}
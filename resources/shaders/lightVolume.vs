@@ -0,0 +1,25 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+layout (std140) uniform CameraBlock {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
+
+// one instance per light, laid out as described in rg::ClusteredLighting
+uniform samplerBuffer pointLights;
+
+// the light is fetched here once per vertex instead of for every covered pixel
+flat out vec4 LightPositionRadius;
+flat out vec4 LightAmbientConstant;
+flat out vec4 LightDiffuseLinear;
+flat out vec4 LightSpecularQuadratic;
+
+void main() {
+    LightPositionRadius = texelFetch(pointLights, 4 * gl_InstanceID);
+    LightAmbientConstant = texelFetch(pointLights, 4 * gl_InstanceID + 1);
+    LightDiffuseLinear = texelFetch(pointLights, 4 * gl_InstanceID + 2);
+    LightSpecularQuadratic = texelFetch(pointLights, 4 * gl_InstanceID + 3);
+    gl_Position = projection * view * vec4(LightPositionRadius.xyz + aPos * LightPositionRadius.w, 1.0);
+}
@@ -0,0 +1,33 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D image;
+// false: log luminance of the hdr buffer, true: average of a 2x2 block of the previous level
+uniform bool reduce;
+
+// has to match AutoExposure::SIZE
+const int SIZE = 256;
+
+void main() {
+    if (reduce) {
+        FragColor = vec4(texture(image, TexCoords).r, 0.0, 0.0, 1.0);
+        return;
+    }
+    // every hdr pixel of the block this texel stands for, a single filtered tap would only see the 2x2 at its center
+    ivec2 hdrSize = textureSize(image, 0);
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    ivec2 begin = texel * hdrSize / SIZE;
+    ivec2 end = max((texel + 1) * hdrSize / SIZE, begin + 1);
+    float sum = 0.0;
+    for (int y = begin.y; y < end.y; ++y) {
+        for (int x = begin.x; x < end.x; ++x) {
+            float luminance = dot(texelFetch(image, ivec2(x, y), 0).rgb, vec3(0.2126, 0.7152, 0.0722));
+            // black pixels would pull the log average to minus infinity
+            sum += log(max(luminance, 0.0001));
+        }
+    }
+    ivec2 count = end - begin;
+    FragColor = vec4(sum / float(count.x * count.y), 0.0, 0.0, 1.0);
+}
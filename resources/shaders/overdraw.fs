@@ -0,0 +1,10 @@
+#version 330 core
+layout (location = 0) out vec4 FragColor;
+layout (location = 1) out vec4 BrightColor;
+
+// every shaded fragment adds one to the red channel, blended with GL_ONE, GL_ONE
+void main()
+{
+    FragColor = vec4(1.0, 0.0, 0.0, 0.0);
+    BrightColor = vec4(0.0);
+}
@@ -0,0 +1,21 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+// fragments shaded per pixel, written by overdraw.fs
+uniform sampler2D counts;
+
+// black for nothing, then blue, green, yellow, red; white from 8 fragments on
+vec3 heat(float count) {
+    const vec3 colors[6] = vec3[](vec3(0.0), vec3(0.0, 0.0, 1.0), vec3(0.0, 1.0, 0.0),
+                                  vec3(1.0, 1.0, 0.0), vec3(1.0, 0.0, 0.0), vec3(1.0));
+    float x = clamp(count <= 4.0 ? count : 4.0 + (count - 4.0) / 4.0, 0.0, 5.0);
+    int i = int(min(floor(x), 4.0));
+    return mix(colors[i], colors[i + 1], x - float(i));
+}
+
+void main()
+{
+    FragColor = vec4(heat(texture(counts, TexCoords).r), 1.0);
+}
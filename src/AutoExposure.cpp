@@ -0,0 +1,136 @@
+#include "rg/AutoExposure.h"
+#include "rg/GLState.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace rg {
+
+    AutoExposure::AutoExposure()
+            : m_Luminance("resources/shaders/bloom.vs", "resources/shaders/luminance.fs"),
+              m_Next(0), m_AverageLuminance(0.18f), m_Exposure(1.0f), m_Frame(0), m_Latency(0) {
+        m_LuminanceReduce = m_Luminance.uniform<bool>("reduce");
+        m_Luminance.use();
+        m_Luminance.setInt("image", 0);
+
+        for (int size = SIZE; size >= 1; size /= 2) {
+            Level level;
+            level.size = size;
+            glGenTextures(1, &level.texture);
+            GLState::bindTexture(level.texture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R16F, size, size, 0, GL_RED, GL_FLOAT, NULL);
+            // a linear fetch in the middle of a 2x2 block averages it
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+            glGenFramebuffers(1, &level.framebuffer);
+            GLState::bindFramebuffer(level.framebuffer);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, level.texture, 0);
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+                std::cout << "Framebuffer not complete!" << std::endl;
+            m_Levels.push_back(level);
+        }
+
+        for (Readback &readback: m_Ring) {
+            glGenBuffers(1, &readback.buffer);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+            glBufferData(GL_PIXEL_PACK_BUFFER, sizeof(float), NULL, GL_STREAM_READ);
+            readback.fence = 0;
+            readback.frame = 0;
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    void AutoExposure::collect() {
+        // oldest first, so the newest finished result is the one that stays
+        for (unsigned int i = 0; i < RING; ++i) {
+            Readback &readback = m_Ring[(m_Next + i) % RING];
+            if (!readback.fence) {
+                continue;
+            }
+            GLenum status = glClientWaitSync(readback.fence, 0, 0);
+            if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED) {
+                continue;
+            }
+            glDeleteSync(readback.fence);
+            readback.fence = 0;
+
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+            float *logAverage = (float *) glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, sizeof(float), GL_MAP_READ_BIT);
+            if (logAverage) {
+                m_AverageLuminance = std::exp(*logAverage);
+                m_Latency = m_Frame - readback.frame;
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            }
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    void AutoExposure::update(unsigned int hdrTexture, float deltaTime, const Settings &settings,
+                              void (*drawQuad)(), int width, int height) {
+        ++m_Frame;
+
+        m_Luminance.use();
+        for (unsigned int i = 0; i < m_Levels.size(); ++i) {
+            GLState::bindFramebuffer(m_Levels[i].framebuffer);
+            GLState::viewport(0, 0, m_Levels[i].size, m_Levels[i].size);
+            GLState::bindTexture(0, i == 0 ? hdrTexture : m_Levels[i - 1].texture);
+            m_LuminanceReduce.set(i != 0);
+            drawQuad();
+        }
+        GLState::viewport(0, 0, width, height);
+
+        if (settings.sync) {
+            float logAverage;
+            glReadPixels(0, 0, 1, 1, GL_RED, GL_FLOAT, &logAverage);
+            m_AverageLuminance = std::exp(logAverage);
+            m_Latency = 0;
+        } else {
+            collect();
+            // with every slot still in flight the GPU is more than RING frames behind, skip this measurement
+            Readback &readback = m_Ring[m_Next];
+            if (!readback.fence) {
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+                glReadPixels(0, 0, 1, 1, GL_RED, GL_FLOAT, (void *) 0);
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+                readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                readback.frame = m_Frame;
+                m_Next = (m_Next + 1) % RING;
+            }
+        }
+
+        float target = settings.key / std::max(m_AverageLuminance, 0.0001f);
+        target = std::min(std::max(target, settings.minExposure), settings.maxExposure);
+        m_Exposure += (target - m_Exposure) * (1.0f - std::exp(-deltaTime * settings.adaptationRate));
+    }
+
+    float AutoExposure::getExposure() const {
+        return m_Exposure;
+    }
+
+    float AutoExposure::getAverageLuminance() const {
+        return m_AverageLuminance;
+    }
+
+    unsigned int AutoExposure::getLatency() const {
+        return m_Latency;
+    }
+
+    void AutoExposure::free() {
+        for (Readback &readback: m_Ring) {
+            if (readback.fence) {
+                glDeleteSync(readback.fence);
+            }
+            glDeleteBuffers(1, &readback.buffer);
+        }
+        for (Level &level: m_Levels) {
+            GLState::deleteFramebuffers(1, &level.framebuffer);
+            GLState::deleteTextures(1, &level.texture);
+        }
+        m_Levels.clear();
+        m_Luminance.deleteProgram();
+    }
+
+}
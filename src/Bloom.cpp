@@ -0,0 +1,117 @@
+#include "rg/Bloom.h"
+#include "rg/GLState.h"
+#include <iostream>
+
+namespace rg {
+
+    Bloom::Bloom(int width, int height, unsigned int maxLevels)
+            : m_Downsample("resources/shaders/bloom.vs", "resources/shaders/bloomDownsample.fs"),
+              m_Upsample("resources/shaders/bloom.vs", "resources/shaders/bloomUpsample.fs"),
+              m_MaxLevels(maxLevels), m_Width(width), m_Height(height) {
+        m_DownsampleTexel = m_Downsample.uniform<glm::vec2>("texelSize");
+        m_DownsampleKaris = m_Downsample.uniform<bool>("karisAverage");
+        m_UpsampleRadius = m_Upsample.uniform<glm::vec2>("radius");
+        m_Downsample.use();
+        m_Downsample.setInt("image", 0);
+        m_Upsample.use();
+        m_Upsample.setInt("image", 0);
+        createLevels();
+    }
+
+    void Bloom::resize(int width, int height) {
+        m_Width = width;
+        m_Height = height;
+        deleteLevels();
+        createLevels();
+    }
+
+    void Bloom::createLevels() {
+        int width = m_Width;
+        int height = m_Height;
+        while (m_Levels.size() < m_MaxLevels && width >= 4 && height >= 4) {
+            width /= 2;
+            height /= 2;
+
+            Level level;
+            level.width = width;
+            level.height = height;
+            glGenTextures(1, &level.texture);
+            GLState::bindTexture(level.texture);
+            // no alpha, half the bandwidth of GL_RGBA16F
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R11F_G11F_B10F, width, height, 0, GL_RGB, GL_FLOAT, NULL);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+            glGenFramebuffers(1, &level.framebuffer);
+            GLState::bindFramebuffer(level.framebuffer);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, level.texture, 0);
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+                std::cout << "Framebuffer not complete!" << std::endl;
+            m_Levels.push_back(level);
+        }
+    }
+
+    void Bloom::deleteLevels() {
+        for (Level &level: m_Levels) {
+            GLState::deleteFramebuffers(1, &level.framebuffer);
+            GLState::deleteTextures(1, &level.texture);
+        }
+        m_Levels.clear();
+    }
+
+    unsigned int Bloom::render(unsigned int source, float radius, void (*drawQuad)()) {
+        if (m_Levels.empty()) {
+            return 0;
+        }
+
+        // every level is written completely, nothing to blend until the way up
+        GLState::disable(GL_BLEND);
+        m_Downsample.use();
+        int sourceWidth = m_Width;
+        int sourceHeight = m_Height;
+        unsigned int sourceTexture = source;
+        for (unsigned int i = 0; i < m_Levels.size(); ++i) {
+            const Level &level = m_Levels[i];
+            GLState::bindFramebuffer(level.framebuffer);
+            GLState::viewport(0, 0, level.width, level.height);
+            GLState::bindTexture(0, sourceTexture);
+            m_DownsampleTexel.set(glm::vec2(1.0f / sourceWidth, 1.0f / sourceHeight));
+            // weighting by luminance on the first step keeps single very bright pixels from flickering
+            m_DownsampleKaris.set(i == 0);
+            drawQuad();
+            sourceTexture = level.texture;
+            sourceWidth = level.width;
+            sourceHeight = level.height;
+        }
+
+        GLState::enable(GL_BLEND);
+        GLState::blendFunc(GL_ONE, GL_ONE);
+        m_Upsample.use();
+        for (unsigned int i = m_Levels.size() - 1; i > 0; --i) {
+            const Level &lower = m_Levels[i];
+            const Level &upper = m_Levels[i - 1];
+            GLState::bindFramebuffer(upper.framebuffer);
+            GLState::viewport(0, 0, upper.width, upper.height);
+            GLState::bindTexture(0, lower.texture);
+            m_UpsampleRadius.set(glm::vec2(radius / lower.width, radius / lower.height));
+            drawQuad();
+        }
+        GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        GLState::viewport(0, 0, m_Width, m_Height);
+        return m_Levels[0].texture;
+    }
+
+    unsigned int Bloom::getLevelCount() const {
+        return m_Levels.size();
+    }
+
+    void Bloom::free() {
+        deleteLevels();
+        m_Downsample.deleteProgram();
+        m_Upsample.deleteProgram();
+    }
+
+}
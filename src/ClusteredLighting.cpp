@@ -0,0 +1,218 @@
+#include "rg/ClusteredLighting.h"
+#include <algorithm>
+#include <cmath>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+namespace rg {
+
+    ClusteredLighting::ClusteredLighting()
+            : m_FovY(0.0f), m_Aspect(0.0f), m_Near(0.0f), m_Far(0.0f), m_Width(0), m_Height(0),
+              m_MaxLightsPerCluster(0), m_LightBuffer(GL_RGBA32F), m_GridBuffer(GL_RG32UI), m_IndexBuffer(GL_R32UI) {
+        m_Grid.assign(2 * CLUSTER_COUNT, 0);
+    }
+
+    void ClusteredLighting::setProjection(float fovY, float aspect, float near, float far, int width, int height) {
+        if (fovY == m_FovY && aspect == m_Aspect && near == m_Near && far == m_Far && width == m_Width && height == m_Height) {
+            return;
+        }
+        m_FovY = fovY;
+        m_Aspect = aspect;
+        m_Near = near;
+        m_Far = far;
+        m_Width = width;
+        m_Height = height;
+        buildClusters();
+    }
+
+    void ClusteredLighting::buildClusters() {
+        m_Clusters.resize(CLUSTER_COUNT);
+        glm::vec4 params = getParams();
+        float tanY = std::tan(m_FovY * 0.5f);
+        float tanX = tanY * m_Aspect;
+
+        for (unsigned int z = 0; z < GRID_Z; ++z) {
+            // exponential slices, each one covers the same depth ratio
+            float sliceNear = m_Near * std::pow(m_Far / m_Near, (float) z / GRID_Z);
+            float sliceFar = m_Near * std::pow(m_Far / m_Near, (float) (z + 1) / GRID_Z);
+            for (unsigned int y = 0; y < GRID_Y; ++y) {
+                float bottom = std::min(y * params.y / m_Height, 1.0f) * 2.0f - 1.0f;
+                float top = std::min((y + 1) * params.y / m_Height, 1.0f) * 2.0f - 1.0f;
+                for (unsigned int x = 0; x < GRID_X; ++x) {
+                    float left = std::min(x * params.x / m_Width, 1.0f) * 2.0f - 1.0f;
+                    float right = std::min((x + 1) * params.x / m_Width, 1.0f) * 2.0f - 1.0f;
+
+                    // the tile's corners on both slice planes, the view looks down -z
+                    AABB bounds;
+                    bounds.min = bounds.max = glm::vec3(left * tanX * sliceNear, bottom * tanY * sliceNear, -sliceNear);
+                    float depths[2] = {sliceNear, sliceFar};
+                    for (float depth: depths) {
+                        bounds.expand(glm::vec3(left * tanX * depth, bottom * tanY * depth, -depth));
+                        bounds.expand(glm::vec3(right * tanX * depth, bottom * tanY * depth, -depth));
+                        bounds.expand(glm::vec3(left * tanX * depth, top * tanY * depth, -depth));
+                        bounds.expand(glm::vec3(right * tanX * depth, top * tanY * depth, -depth));
+                    }
+                    m_Clusters[x + y * GRID_X + z * GRID_X * GRID_Y] = bounds;
+                }
+            }
+        }
+    }
+
+    void ClusteredLighting::clearLights() {
+        m_Lights.clear();
+        m_Radius.clear();
+    }
+
+    void ClusteredLighting::addLight(const PointLightData &light) {
+        m_Lights.push_back(light);
+        m_Radius.push_back(lightRadius(light));
+    }
+
+    float ClusteredLighting::lightRadius(const PointLightData &light) {
+        float brightest = std::max(std::max(std::max(light.ambient.x, light.ambient.y), light.ambient.z),
+                                   std::max(std::max(light.diffuse.x, light.diffuse.y), light.diffuse.z));
+        brightest = std::max(brightest, std::max(std::max(light.specular.x, light.specular.y), light.specular.z));
+        // brightest / (constant + linear * d + quadratic * d^2) = 5 / 256
+        float c = light.constant - brightest * 256.0f / 5.0f;
+        if (light.quadratic <= 0.0f) {
+            return light.linear > 0.0f ? std::max(-c / light.linear, 0.0f) : 1e30f;
+        }
+        return std::max((-light.linear + std::sqrt(light.linear * light.linear - 4.0f * light.quadratic * c)) / (2.0f * light.quadratic), 0.0f);
+    }
+
+    void ClusteredLighting::uploadLights() {
+        unsigned int lightCount = m_Lights.size();
+        m_LightTexels.resize(16 * lightCount);
+        for (unsigned int i = 0; i < lightCount; ++i) {
+            const PointLightData &light = m_Lights[i];
+            float *texels = &m_LightTexels[16 * i];
+            texels[0] = light.position.x; texels[1] = light.position.y; texels[2] = light.position.z; texels[3] = m_Radius[i];
+            texels[4] = light.ambient.x; texels[5] = light.ambient.y; texels[6] = light.ambient.z; texels[7] = light.constant;
+            texels[8] = light.diffuse.x; texels[9] = light.diffuse.y; texels[10] = light.diffuse.z; texels[11] = light.linear;
+            texels[12] = light.specular.x; texels[13] = light.specular.y; texels[14] = light.specular.z; texels[15] = light.quadratic;
+        }
+        m_LightBuffer.upload(m_LightTexels.data(), m_LightTexels.size() * sizeof(float));
+    }
+
+    void ClusteredLighting::update(const glm::mat4 &view) {
+        uploadLights();
+        unsigned int lightCount = m_Lights.size();
+        std::vector<glm::vec3> viewPositions(lightCount);
+        for (unsigned int i = 0; i < lightCount; ++i) {
+            viewPositions[i] = glm::vec3(view * glm::vec4(m_Lights[i].position, 1.0f));
+        }
+
+        m_Indices.clear();
+        m_MaxLightsPerCluster = 0;
+        for (unsigned int z = 0; z < GRID_Z; ++z) {
+            // lights reaching into the slice's depth range, the only ones its froxels have to test
+            const AABB &first = m_Clusters[z * GRID_X * GRID_Y];
+            float sliceNear = -first.max.z;
+            float sliceFar = -first.min.z;
+            m_SliceX.clear();
+            m_SliceY.clear();
+            m_SliceZ.clear();
+            m_SliceRadius.clear();
+            m_SliceLights.clear();
+            for (unsigned int i = 0; i < lightCount; ++i) {
+                float depth = -viewPositions[i].z;
+                if (depth + m_Radius[i] >= sliceNear && depth - m_Radius[i] <= sliceFar) {
+                    m_SliceX.push_back(viewPositions[i].x);
+                    m_SliceY.push_back(viewPositions[i].y);
+                    m_SliceZ.push_back(viewPositions[i].z);
+                    m_SliceRadius.push_back(m_Radius[i]);
+                    m_SliceLights.push_back(i);
+                }
+            }
+            unsigned int candidates = m_SliceLights.size();
+            // padding lanes have a negative radius and never pass
+            while (m_SliceX.size() % 4) {
+                m_SliceX.push_back(0.0f);
+                m_SliceY.push_back(0.0f);
+                m_SliceZ.push_back(0.0f);
+                m_SliceRadius.push_back(-1.0f);
+            }
+
+            for (unsigned int cluster = z * GRID_X * GRID_Y; cluster < (z + 1) * GRID_X * GRID_Y; ++cluster) {
+                const AABB &bounds = m_Clusters[cluster];
+                unsigned int offset = m_Indices.size();
+#ifdef __SSE__
+                __m128 minX = _mm_set1_ps(bounds.min.x), maxX = _mm_set1_ps(bounds.max.x);
+                __m128 minY = _mm_set1_ps(bounds.min.y), maxY = _mm_set1_ps(bounds.max.y);
+                __m128 minZ = _mm_set1_ps(bounds.min.z), maxZ = _mm_set1_ps(bounds.max.z);
+                __m128 zero = _mm_setzero_ps();
+                for (unsigned int i = 0; i < candidates; i += 4) {
+                    __m128 centerX = _mm_loadu_ps(&m_SliceX[i]);
+                    __m128 centerY = _mm_loadu_ps(&m_SliceY[i]);
+                    __m128 centerZ = _mm_loadu_ps(&m_SliceZ[i]);
+                    __m128 radius = _mm_loadu_ps(&m_SliceRadius[i]);
+                    // distance from the sphere center to the box, per axis
+                    __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minX, centerX), _mm_sub_ps(centerX, maxX)), zero);
+                    __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minY, centerY), _mm_sub_ps(centerY, maxY)), zero);
+                    __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minZ, centerZ), _mm_sub_ps(centerZ, maxZ)), zero);
+                    __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+                    __m128 touches = _mm_and_ps(_mm_cmple_ps(distance, _mm_mul_ps(radius, radius)), _mm_cmpge_ps(radius, zero));
+                    int mask = _mm_movemask_ps(touches);
+                    while (mask) {
+                        int lane = __builtin_ctz(mask);
+                        mask &= mask - 1;
+                        m_Indices.push_back(m_SliceLights[i + lane]);
+                    }
+                }
+#else
+                for (unsigned int i = 0; i < candidates; ++i) {
+                    glm::vec3 center(m_SliceX[i], m_SliceY[i], m_SliceZ[i]);
+                    glm::vec3 delta = glm::max(glm::max(bounds.min - center, center - bounds.max), glm::vec3(0.0f));
+                    if (glm::dot(delta, delta) <= m_SliceRadius[i] * m_SliceRadius[i]) {
+                        m_Indices.push_back(m_SliceLights[i]);
+                    }
+                }
+#endif
+                unsigned int count = m_Indices.size() - offset;
+                m_Grid[2 * cluster] = offset;
+                m_Grid[2 * cluster + 1] = count;
+                m_MaxLightsPerCluster = std::max(m_MaxLightsPerCluster, count);
+            }
+        }
+
+        m_GridBuffer.upload(m_Grid.data(), m_Grid.size() * sizeof(std::uint32_t));
+        m_IndexBuffer.upload(m_Indices.data(), m_Indices.size() * sizeof(std::uint32_t));
+    }
+
+    void ClusteredLighting::bind() const {
+        m_LightBuffer.bind(LIGHT_TEXTURE_UNIT);
+        m_GridBuffer.bind(LIGHT_TEXTURE_UNIT + 1);
+        m_IndexBuffer.bind(LIGHT_TEXTURE_UNIT + 2);
+    }
+
+    glm::uvec4 ClusteredLighting::getGrid() const {
+        return glm::uvec4(GRID_X, GRID_Y, GRID_Z, 0);
+    }
+
+    glm::vec4 ClusteredLighting::getParams() const {
+        float tileWidth = std::ceil((float) m_Width / GRID_X);
+        float tileHeight = std::ceil((float) m_Height / GRID_Y);
+        return glm::vec4(tileWidth, tileHeight, m_Near, GRID_Z / std::log(m_Far / m_Near));
+    }
+
+    unsigned int ClusteredLighting::getLightCount() const {
+        return m_Lights.size();
+    }
+
+    unsigned int ClusteredLighting::getIndexCount() const {
+        return m_Indices.size();
+    }
+
+    unsigned int ClusteredLighting::getMaxLightsPerCluster() const {
+        return m_MaxLightsPerCluster;
+    }
+
+    void ClusteredLighting::free() {
+        m_LightBuffer.free();
+        m_GridBuffer.free();
+        m_IndexBuffer.free();
+    }
+
+}
@@ -0,0 +1,114 @@
+#include "rg/ComputePostProcess.h"
+#include "rg/GLExtensions.h"
+#include "rg/GLState.h"
+#include "rg/GaussianKernel.h"
+#include <iostream>
+
+namespace rg {
+
+    ComputePostProcess::ComputePostProcess(int width, int height)
+            : m_Horizontal("resources/shaders/bloomHorizontal.cs"),
+              m_Resolve("resources/shaders/bloomResolve.cs"),
+              m_Width(width), m_Height(height), m_Sigma(-1.0f) {
+        m_HorizontalRadius = m_Horizontal.uniform<int>("radius");
+        m_HorizontalWeights = m_Horizontal.uniform<float>("weights");
+        m_ResolveRadius = m_Resolve.uniform<int>("radius");
+        m_ResolveWeights = m_Resolve.uniform<float>("weights");
+        m_ResolveHdr = m_Resolve.uniform<bool>("hdr");
+        m_ResolveBloom = m_Resolve.uniform<bool>("bloom");
+        m_ResolveExposure = m_Resolve.uniform<float>("exposure");
+
+        m_Horizontal.use();
+        m_Horizontal.setInt("image", 0);
+        m_Horizontal.setInt("result", 0);
+        m_Resolve.use();
+        m_Resolve.setInt("image", 0);
+        m_Resolve.setInt("hdrBuffer", 1);
+        m_Resolve.setInt("result", 0);
+        createTargets();
+    }
+
+    bool ComputePostProcess::isValid() const {
+        return m_Horizontal.isLinked() && m_Resolve.isLinked();
+    }
+
+    void ComputePostProcess::resize(int width, int height) {
+        m_Width = width;
+        m_Height = height;
+        deleteTargets();
+        createTargets();
+    }
+
+    void ComputePostProcess::createTargets() {
+        glGenTextures(1, &m_BlurTexture);
+        GLState::bindTexture(m_BlurTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R11F_G11F_B10F, m_Width, m_Height, 0, GL_RGB, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        glGenTextures(1, &m_OutputTexture);
+        GLState::bindTexture(m_OutputTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_Width, m_Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        glGenFramebuffers(1, &m_OutputFramebuffer);
+        GLState::bindFramebuffer(m_OutputFramebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_OutputTexture, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "Framebuffer not complete!" << std::endl;
+    }
+
+    void ComputePostProcess::deleteTargets() {
+        GLState::deleteFramebuffers(1, &m_OutputFramebuffer);
+        GLState::deleteTextures(1, &m_OutputTexture);
+        GLState::deleteTextures(1, &m_BlurTexture);
+    }
+
+    void ComputePostProcess::render(unsigned int hdrTexture, unsigned int brightTexture, float sigma,
+                                    bool bloom, bool hdr, float exposure, unsigned int targetFramebuffer) {
+        if (sigma != m_Sigma) {
+            m_Sigma = sigma;
+            GaussianKernel kernel = GaussianKernel::make(sigma);
+            m_Horizontal.use();
+            m_HorizontalRadius.set((int) kernel.radius);
+            glUniform1fv(m_HorizontalWeights.location(), kernel.radius + 1, kernel.discreteWeights);
+            m_Resolve.use();
+            m_ResolveRadius.set((int) kernel.radius);
+            glUniform1fv(m_ResolveWeights.location(), kernel.radius + 1, kernel.discreteWeights);
+        }
+
+        if (bloom) {
+            m_Horizontal.use();
+            GLState::bindTexture(0, brightTexture);
+            GLExtensions::bindImageTexture(0, m_BlurTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R11F_G11F_B10F);
+            GLExtensions::dispatchCompute((m_Width + TILE - 1) / TILE, m_Height, 1);
+            // the resolve reads the rows back through a sampler
+            GLExtensions::memoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+        }
+
+        m_Resolve.use();
+        m_ResolveHdr.set(hdr);
+        m_ResolveBloom.set(bloom);
+        m_ResolveExposure.set(exposure);
+        GLState::bindTexture(0, m_BlurTexture);
+        GLState::bindTexture(1, hdrTexture);
+        GLExtensions::bindImageTexture(0, m_OutputTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+        GLExtensions::dispatchCompute(m_Width, (m_Height + TILE - 1) / TILE, 1);
+        GLExtensions::memoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT);
+
+        // GLState only knows both targets together: bind the output for reading and the target
+        // for drawing behind its back, then both to the target, which it forwards because it differs
+        GLState::bindFramebuffer(m_OutputFramebuffer);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, targetFramebuffer);
+        glBlitFramebuffer(0, 0, m_Width, m_Height, 0, 0, m_Width, m_Height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        GLState::bindFramebuffer(targetFramebuffer);
+    }
+
+    void ComputePostProcess::free() {
+        deleteTargets();
+        m_Horizontal.deleteProgram();
+        m_Resolve.deleteProgram();
+    }
+
+}
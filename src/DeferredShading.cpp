@@ -0,0 +1,213 @@
+#include "rg/DeferredShading.h"
+#include "rg/ClusteredLighting.h"
+#include "rg/GLState.h"
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace rg {
+
+    // texture units of the G-buffer and of the light volume sum while lighting
+    static const unsigned int ALBEDO_UNIT = 0;
+    static const unsigned int NORMAL_UNIT = 1;
+    static const unsigned int SPECULAR_UNIT = 2;
+    static const unsigned int DEPTH_UNIT = 3;
+    static const unsigned int POINT_LIGHTING_UNIT = 4;
+
+    static const unsigned int SPHERE_SEGMENTS = 16;
+    static const unsigned int SPHERE_RINGS = 8;
+
+    DeferredShading::DeferredShading(int width, int height, unsigned int colorBuffer, unsigned int brightBuffer)
+            : m_LightVolume("resources/shaders/lightVolume.vs", "resources/shaders/lightVolume.fs"),
+              m_Resolve("resources/shaders/hdr.vs", "resources/shaders/deferredResolve.fs"),
+              m_ColorBuffer(colorBuffer), m_BrightBuffer(brightBuffer), m_Width(width), m_Height(height) {
+        m_VolumeInverseViewProjection = m_LightVolume.uniform<glm::mat4>("inverseViewProjection");
+        m_ResolveInverseViewProjection = m_Resolve.uniform<glm::mat4>("inverseViewProjection");
+        Shader *shaders[] = {&m_LightVolume, &m_Resolve};
+        for (Shader *shader: shaders) {
+            shader->use();
+            shader->setInt("gAlbedo", ALBEDO_UNIT);
+            shader->setInt("gNormal", NORMAL_UNIT);
+            shader->setInt("gSpecular", SPECULAR_UNIT);
+            shader->setInt("gDepth", DEPTH_UNIT);
+        }
+        m_LightVolume.use();
+        m_LightVolume.setInt("pointLights", ClusteredLighting::LIGHT_TEXTURE_UNIT);
+        m_Resolve.use();
+        m_Resolve.setInt("pointLighting", POINT_LIGHTING_UNIT);
+        createTargets();
+        createSphere();
+    }
+
+    void DeferredShading::resize(int width, int height) {
+        m_Width = width;
+        m_Height = height;
+        deleteTargets();
+        createTargets();
+    }
+
+    void DeferredShading::bindUniformBlock(const std::string &blockName, unsigned int binding) const {
+        m_LightVolume.bindUniformBlock(blockName, binding);
+        m_Resolve.bindUniformBlock(blockName, binding);
+    }
+
+    void DeferredShading::createTargets() {
+        const GLenum formats[TARGET_COUNT][3] = {
+                {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE},
+                {GL_RG16F, GL_RG, GL_FLOAT},
+                {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE}
+        };
+        glGenFramebuffers(1, &m_GBuffer);
+        GLState::bindFramebuffer(m_GBuffer);
+        glGenTextures(TARGET_COUNT, m_Targets);
+        unsigned int attachments[TARGET_COUNT];
+        for (unsigned int i = 0; i < TARGET_COUNT; ++i) {
+            GLState::bindTexture(m_Targets[i]);
+            glTexImage2D(GL_TEXTURE_2D, 0, formats[i][0], m_Width, m_Height, 0, formats[i][1], formats[i][2], NULL);
+            // only ever read with texelFetch
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, m_Targets[i], 0);
+            attachments[i] = GL_COLOR_ATTACHMENT0 + i;
+        }
+        glDrawBuffers(TARGET_COUNT, attachments);
+
+        glGenTextures(1, &m_Depth);
+        GLState::bindTexture(m_Depth);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, m_Width, m_Height, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_Depth, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "Framebuffer not complete!" << std::endl;
+
+        glGenFramebuffers(1, &m_LightBuffer);
+        GLState::bindFramebuffer(m_LightBuffer);
+        glGenTextures(1, &m_LightTexture);
+        GLState::bindTexture(m_LightTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, m_Width, m_Height, 0, GL_RGBA, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_LightTexture, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "Framebuffer not complete!" << std::endl;
+
+        // the depth can't be attached while the lighting passes sample it, hence a framebuffer of its own
+        glGenFramebuffers(1, &m_ForwardBuffer);
+        GLState::bindFramebuffer(m_ForwardBuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_ColorBuffer, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, m_BrightBuffer, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_Depth, 0);
+        unsigned int hdrAttachments[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+        glDrawBuffers(2, hdrAttachments);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "Framebuffer not complete!" << std::endl;
+        GLState::bindFramebuffer(0);
+    }
+
+    void DeferredShading::deleteTargets() {
+        unsigned int framebuffers[3] = {m_GBuffer, m_LightBuffer, m_ForwardBuffer};
+        GLState::deleteFramebuffers(3, framebuffers);
+        GLState::deleteTextures(TARGET_COUNT, m_Targets);
+        GLState::deleteTextures(1, &m_Depth);
+        GLState::deleteTextures(1, &m_LightTexture);
+    }
+
+    void DeferredShading::createSphere() {
+        // a unit sphere grown until its flat faces enclose the unit sphere, so the light's whole range is covered
+        float grow = 1.0f / (std::cos(glm::radians(180.0f) / SPHERE_SEGMENTS) * std::cos(glm::radians(90.0f) / SPHERE_RINGS));
+        std::vector<float> vertices;
+        for (unsigned int ring = 0; ring <= SPHERE_RINGS; ++ring) {
+            float theta = glm::radians(180.0f) * ring / SPHERE_RINGS;
+            for (unsigned int segment = 0; segment <= SPHERE_SEGMENTS; ++segment) {
+                float phi = glm::radians(360.0f) * segment / SPHERE_SEGMENTS;
+                vertices.push_back(grow * std::sin(theta) * std::cos(phi));
+                vertices.push_back(grow * std::cos(theta));
+                vertices.push_back(grow * std::sin(theta) * std::sin(phi));
+            }
+        }
+        // counter-clockwise seen from outside
+        std::vector<unsigned int> indices;
+        for (unsigned int ring = 0; ring < SPHERE_RINGS; ++ring) {
+            for (unsigned int segment = 0; segment < SPHERE_SEGMENTS; ++segment) {
+                unsigned int current = ring * (SPHERE_SEGMENTS + 1) + segment;
+                unsigned int below = current + SPHERE_SEGMENTS + 1;
+                indices.push_back(current);
+                indices.push_back(current + 1);
+                indices.push_back(below);
+                indices.push_back(current + 1);
+                indices.push_back(below + 1);
+                indices.push_back(below);
+            }
+        }
+        m_SphereIndexCount = indices.size();
+
+        glGenVertexArrays(1, &m_SphereVAO);
+        glGenBuffers(1, &m_SphereVBO);
+        glGenBuffers(1, &m_SphereEBO);
+        GLState::bindVertexArray(m_SphereVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, m_SphereVBO);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_SphereEBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *) 0);
+        GLState::bindVertexArray(0);
+    }
+
+    void DeferredShading::beginGeometry() {
+        GLState::bindFramebuffer(m_GBuffer);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        // the alpha channels hold data, light() turns blending back on
+        GLState::disable(GL_BLEND);
+    }
+
+    void DeferredShading::light(unsigned int lightCount, const glm::mat4 &inverseViewProjection, void (*drawQuad)()) {
+        for (unsigned int i = 0; i < TARGET_COUNT; ++i) {
+            GLState::bindTexture(ALBEDO_UNIT + i, m_Targets[i]);
+        }
+        GLState::bindTexture(DEPTH_UNIT, m_Depth);
+
+        // point lights: the back faces of every volume, so it still covers its pixels with the camera inside it
+        GLState::bindFramebuffer(m_LightBuffer);
+        glClear(GL_COLOR_BUFFER_BIT);
+        GLState::disable(GL_DEPTH_TEST);
+        if (lightCount > 0) {
+            GLState::enable(GL_CULL_FACE);
+            GLState::cullFace(GL_FRONT);
+            GLState::frontFace(GL_CCW);
+            GLState::enable(GL_BLEND);
+            GLState::blendFunc(GL_ONE, GL_ONE);
+            // volumes reaching past the far plane are flattened onto it instead of clipped
+            GLState::enable(GL_DEPTH_CLAMP);
+            m_LightVolume.use();
+            m_VolumeInverseViewProjection.set(inverseViewProjection);
+            GLState::bindVertexArray(m_SphereVAO);
+            glDrawElementsInstanced(GL_TRIANGLES, m_SphereIndexCount, GL_UNSIGNED_INT, 0, lightCount);
+            GLState::disable(GL_DEPTH_CLAMP);
+            GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        }
+
+        // directional light plus the point lights into the hdr buffers, every pixel is written once
+        GLState::bindFramebuffer(m_ForwardBuffer);
+        GLState::disable(GL_BLEND);
+        GLState::disable(GL_CULL_FACE);
+        m_Resolve.use();
+        m_ResolveInverseViewProjection.set(inverseViewProjection);
+        GLState::bindTexture(POINT_LIGHTING_UNIT, m_LightTexture);
+        drawQuad();
+        GLState::enable(GL_CULL_FACE);
+        GLState::enable(GL_BLEND);
+        GLState::enable(GL_DEPTH_TEST);
+    }
+
+    void DeferredShading::free() {
+        deleteTargets();
+        GLState::deleteVertexArrays(1, &m_SphereVAO);
+        glDeleteBuffers(1, &m_SphereVBO);
+        glDeleteBuffers(1, &m_SphereEBO);
+        m_LightVolume.deleteProgram();
+        m_Resolve.deleteProgram();
+    }
+
+}
@@ -0,0 +1,61 @@
+#include "rg/Frustum.h"
+
+namespace rg {
+
+    Frustum::Frustum() {
+        // everything is inside
+        for (glm::vec4 &plane: m_Planes) {
+            plane = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        }
+    }
+
+    Frustum::Frustum(const glm::mat4 &viewProjection) {
+        // Gribb & Hartmann, glm is column major so row i is m[0][i], m[1][i], m[2][i], m[3][i]
+        glm::vec4 rows[4];
+        for (int i = 0; i < 4; ++i) {
+            rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+        }
+        m_Planes[0] = rows[3] + rows[0];
+        m_Planes[1] = rows[3] - rows[0];
+        m_Planes[2] = rows[3] + rows[1];
+        m_Planes[3] = rows[3] - rows[1];
+        m_Planes[4] = rows[3] + rows[2];
+        m_Planes[5] = rows[3] - rows[2];
+        for (glm::vec4 &plane: m_Planes) {
+            plane /= glm::length(glm::vec3(plane));
+        }
+    }
+
+    const glm::vec4 &Frustum::getPlane(unsigned int i) const {
+        return m_Planes[i];
+    }
+
+    bool Frustum::intersects(const AABB &box, const glm::mat4 &model) const {
+        // world space box around the transformed one: the center moves, the extents go through |model|
+        glm::vec3 center = glm::vec3(model * glm::vec4(box.center(), 1.0f));
+        glm::vec3 localExtents = box.extents();
+        glm::vec3 extents = glm::abs(glm::vec3(model[0])) * localExtents.x +
+                            glm::abs(glm::vec3(model[1])) * localExtents.y +
+                            glm::abs(glm::vec3(model[2])) * localExtents.z;
+
+        for (const glm::vec4 &plane: m_Planes) {
+            glm::vec3 normal = glm::vec3(plane);
+            float distance = glm::dot(normal, center) + plane.w;
+            float radius = glm::dot(glm::abs(normal), extents);
+            if (distance + radius < 0.0f) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool Frustum::intersects(const glm::vec3 &center, float radius) const {
+        for (const glm::vec4 &plane: m_Planes) {
+            if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+}
@@ -0,0 +1,87 @@
+#include "rg/GLExtensions.h"
+#include <cstring>
+
+namespace rg {
+
+    GLExtensions::DispatchComputeProc GLExtensions::dispatchCompute = nullptr;
+    GLExtensions::BindImageTextureProc GLExtensions::bindImageTexture = nullptr;
+    GLExtensions::MemoryBarrierProc GLExtensions::memoryBarrier = nullptr;
+    GLExtensions::BufferStorageProc GLExtensions::bufferStorage = nullptr;
+    GLExtensions::DrawElementsIndirectProc GLExtensions::drawElementsIndirect = nullptr;
+    GLExtensions::MultiDrawElementsIndirectProc GLExtensions::multiDrawElementsIndirect = nullptr;
+
+    int GLExtensions::s_Major = 0;
+    int GLExtensions::s_Minor = 0;
+    bool GLExtensions::s_Compute = false;
+    bool GLExtensions::s_BufferStorage = false;
+    bool GLExtensions::s_MultiDrawIndirect = false;
+    bool GLExtensions::s_DrawIndirect = false;
+    bool GLExtensions::s_ShaderStorage = false;
+
+    void GLExtensions::load(GLADloadproc loader) {
+        glGetIntegerv(GL_MAJOR_VERSION, &s_Major);
+        glGetIntegerv(GL_MINOR_VERSION, &s_Minor);
+
+        // the .cs files are #version 430, the extensions alone would load the entry points for programs that never link
+        if (hasVersion(4, 3)) {
+            dispatchCompute = (DispatchComputeProc) loader("glDispatchCompute");
+            bindImageTexture = (BindImageTextureProc) loader("glBindImageTexture");
+            memoryBarrier = (MemoryBarrierProc) loader("glMemoryBarrier");
+        }
+        s_Compute = dispatchCompute && bindImageTexture && memoryBarrier;
+
+        if (hasVersion(4, 4) || hasExtension("GL_ARB_buffer_storage")) {
+            bufferStorage = (BufferStorageProc) loader("glBufferStorage");
+        }
+        s_BufferStorage = bufferStorage != nullptr;
+
+        if (hasVersion(4, 0) || hasExtension("GL_ARB_draw_indirect")) {
+            drawElementsIndirect = (DrawElementsIndirectProc) loader("glDrawElementsIndirect");
+        }
+        s_DrawIndirect = drawElementsIndirect != nullptr;
+
+        if (hasVersion(4, 3) || (hasExtension("GL_ARB_multi_draw_indirect") && hasExtension("GL_ARB_base_instance"))) {
+            multiDrawElementsIndirect = (MultiDrawElementsIndirectProc) loader("glMultiDrawElementsIndirect");
+        }
+        s_MultiDrawIndirect = multiDrawElementsIndirect != nullptr;
+
+        // no entry points of its own, glBindBufferBase is core 3.0
+        s_ShaderStorage = hasVersion(4, 3) || hasExtension("GL_ARB_shader_storage_buffer_object");
+    }
+
+    bool GLExtensions::hasVersion(int major, int minor) {
+        return s_Major > major || (s_Major == major && s_Minor >= minor);
+    }
+
+    bool GLExtensions::hasExtension(const char *name) {
+        int count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (int i = 0; i < count; ++i) {
+            if (std::strcmp((const char *) glGetStringi(GL_EXTENSIONS, i), name) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool GLExtensions::hasCompute() {
+        return s_Compute;
+    }
+
+    bool GLExtensions::hasBufferStorage() {
+        return s_BufferStorage;
+    }
+
+    bool GLExtensions::hasDrawIndirect() {
+        return s_DrawIndirect;
+    }
+
+    bool GLExtensions::hasShaderStorage() {
+        return s_ShaderStorage;
+    }
+
+    bool GLExtensions::hasMultiDrawIndirect() {
+        return s_MultiDrawIndirect;
+    }
+
+}
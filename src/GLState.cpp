@@ -0,0 +1,281 @@
+#include "rg/GLState.h"
+
+namespace rg {
+
+    unsigned int GLState::s_Program = GLState::UNKNOWN;
+    unsigned int GLState::s_VertexArray = GLState::UNKNOWN;
+    unsigned int GLState::s_Framebuffer = GLState::UNKNOWN;
+    unsigned int GLState::s_ActiveUnit = GLState::UNKNOWN;
+    unsigned int GLState::s_Textures[GLState::TEXTURE_UNITS];
+    unsigned int GLState::s_Blend = GLState::UNKNOWN;
+    unsigned int GLState::s_CullFace = GLState::UNKNOWN;
+    unsigned int GLState::s_DepthTest = GLState::UNKNOWN;
+    GLenum GLState::s_BlendSrc = GLState::UNKNOWN;
+    GLenum GLState::s_BlendDst = GLState::UNKNOWN;
+    GLenum GLState::s_CullMode = GLState::UNKNOWN;
+    GLenum GLState::s_FrontFace = GLState::UNKNOWN;
+    GLenum GLState::s_DepthFunc = GLState::UNKNOWN;
+    unsigned int GLState::s_DepthMask = GLState::UNKNOWN;
+    unsigned int GLState::s_ColorMask = GLState::UNKNOWN;
+    int GLState::s_Viewport[4] = {-1, -1, -1, -1};
+
+    bool GLState::s_Elide = true;
+    unsigned int GLState::s_Calls = 0;
+    unsigned int GLState::s_Elided = 0;
+    unsigned int GLState::s_CallsLastFrame = 0;
+    unsigned int GLState::s_ElidedLastFrame = 0;
+
+    void GLState::reset() {
+        s_Program = UNKNOWN;
+        s_VertexArray = UNKNOWN;
+        s_Framebuffer = UNKNOWN;
+        s_ActiveUnit = UNKNOWN;
+        for (unsigned int &texture: s_Textures) {
+            texture = UNKNOWN;
+        }
+        s_Blend = UNKNOWN;
+        s_CullFace = UNKNOWN;
+        s_DepthTest = UNKNOWN;
+        s_BlendSrc = UNKNOWN;
+        s_BlendDst = UNKNOWN;
+        s_CullMode = UNKNOWN;
+        s_FrontFace = UNKNOWN;
+        s_DepthFunc = UNKNOWN;
+        s_DepthMask = UNKNOWN;
+        s_ColorMask = UNKNOWN;
+        for (int &value: s_Viewport) {
+            value = -1;
+        }
+    }
+
+    bool GLState::change(unsigned int &current, unsigned int value) {
+        if (s_Elide && current == value) {
+            ++s_Elided;
+            return false;
+        }
+        current = value;
+        ++s_Calls;
+        return true;
+    }
+
+    unsigned int *GLState::capability(GLenum cap) {
+        switch (cap) {
+            case GL_BLEND:
+                return &s_Blend;
+            case GL_CULL_FACE:
+                return &s_CullFace;
+            case GL_DEPTH_TEST:
+                return &s_DepthTest;
+            default:
+                return nullptr;
+        }
+    }
+
+    bool GLState::useProgram(unsigned int program) {
+        if (!change(s_Program, program)) {
+            return false;
+        }
+        glUseProgram(program);
+        return true;
+    }
+
+    bool GLState::bindVertexArray(unsigned int vao) {
+        if (!change(s_VertexArray, vao)) {
+            return false;
+        }
+        glBindVertexArray(vao);
+        return true;
+    }
+
+    bool GLState::bindFramebuffer(unsigned int framebuffer) {
+        if (!change(s_Framebuffer, framebuffer)) {
+            return false;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        return true;
+    }
+
+    bool GLState::activeTexture(unsigned int unit) {
+        if (!change(s_ActiveUnit, unit)) {
+            return false;
+        }
+        glActiveTexture(GL_TEXTURE0 + unit);
+        return true;
+    }
+
+    bool GLState::bindTexture(unsigned int unit, unsigned int texture) {
+        if (unit >= TEXTURE_UNITS) {
+            activeTexture(unit);
+            glBindTexture(GL_TEXTURE_2D, texture);
+            ++s_Calls;
+            return true;
+        }
+        if (s_Elide && s_Textures[unit] == texture) {
+            ++s_Elided;
+            return false;
+        }
+        activeTexture(unit);
+        return bindTexture(texture);
+    }
+
+    bool GLState::bindTexture(unsigned int texture) {
+        if (s_ActiveUnit >= TEXTURE_UNITS) {
+            glBindTexture(GL_TEXTURE_2D, texture);
+            ++s_Calls;
+            return true;
+        }
+        if (!change(s_Textures[s_ActiveUnit], texture)) {
+            return false;
+        }
+        glBindTexture(GL_TEXTURE_2D, texture);
+        return true;
+    }
+
+    bool GLState::enable(GLenum cap) {
+        unsigned int *current = capability(cap);
+        if (current && !change(*current, 1)) {
+            return false;
+        }
+        if (!current) {
+            ++s_Calls;
+        }
+        glEnable(cap);
+        return true;
+    }
+
+    bool GLState::disable(GLenum cap) {
+        unsigned int *current = capability(cap);
+        if (current && !change(*current, 0)) {
+            return false;
+        }
+        if (!current) {
+            ++s_Calls;
+        }
+        glDisable(cap);
+        return true;
+    }
+
+    bool GLState::blendFunc(GLenum src, GLenum dst) {
+        if (s_Elide && s_BlendSrc == src && s_BlendDst == dst) {
+            ++s_Elided;
+            return false;
+        }
+        s_BlendSrc = src;
+        s_BlendDst = dst;
+        ++s_Calls;
+        glBlendFunc(src, dst);
+        return true;
+    }
+
+    bool GLState::cullFace(GLenum mode) {
+        if (!change(s_CullMode, mode)) {
+            return false;
+        }
+        glCullFace(mode);
+        return true;
+    }
+
+    bool GLState::frontFace(GLenum mode) {
+        if (!change(s_FrontFace, mode)) {
+            return false;
+        }
+        glFrontFace(mode);
+        return true;
+    }
+
+    bool GLState::depthFunc(GLenum func) {
+        if (!change(s_DepthFunc, func)) {
+            return false;
+        }
+        glDepthFunc(func);
+        return true;
+    }
+
+    bool GLState::depthMask(bool mask) {
+        if (!change(s_DepthMask, mask ? 1 : 0)) {
+            return false;
+        }
+        glDepthMask(mask ? GL_TRUE : GL_FALSE);
+        return true;
+    }
+
+    bool GLState::colorMask(bool mask) {
+        if (!change(s_ColorMask, mask ? 1 : 0)) {
+            return false;
+        }
+        GLboolean value = mask ? GL_TRUE : GL_FALSE;
+        glColorMask(value, value, value, value);
+        return true;
+    }
+
+    bool GLState::viewport(int x, int y, int width, int height) {
+        if (s_Elide && s_Viewport[0] == x && s_Viewport[1] == y && s_Viewport[2] == width && s_Viewport[3] == height) {
+            ++s_Elided;
+            return false;
+        }
+        s_Viewport[0] = x;
+        s_Viewport[1] = y;
+        s_Viewport[2] = width;
+        s_Viewport[3] = height;
+        ++s_Calls;
+        glViewport(x, y, width, height);
+        return true;
+    }
+
+    void GLState::deleteProgram(unsigned int program) {
+        // a deleted program stays in use until another one replaces it
+        if (s_Program == program) {
+            s_Program = UNKNOWN;
+        }
+        glDeleteProgram(program);
+    }
+
+    void GLState::deleteVertexArrays(int count, const unsigned int *vaos) {
+        for (int i = 0; i < count; ++i) {
+            if (s_VertexArray == vaos[i]) {
+                s_VertexArray = 0;
+            }
+        }
+        glDeleteVertexArrays(count, vaos);
+    }
+
+    void GLState::deleteFramebuffers(int count, const unsigned int *framebuffers) {
+        for (int i = 0; i < count; ++i) {
+            if (s_Framebuffer == framebuffers[i]) {
+                s_Framebuffer = 0;
+            }
+        }
+        glDeleteFramebuffers(count, framebuffers);
+    }
+
+    void GLState::deleteTextures(int count, const unsigned int *textures) {
+        for (int i = 0; i < count; ++i) {
+            for (unsigned int &texture: s_Textures) {
+                if (texture == textures[i]) {
+                    texture = 0;
+                }
+            }
+        }
+        glDeleteTextures(count, textures);
+    }
+
+    void GLState::setElide(bool elide) {
+        s_Elide = elide;
+    }
+
+    unsigned int GLState::callsLastFrame() {
+        return s_CallsLastFrame;
+    }
+
+    unsigned int GLState::elidedLastFrame() {
+        return s_ElidedLastFrame;
+    }
+
+    void GLState::endFrame() {
+        s_CallsLastFrame = s_Calls;
+        s_ElidedLastFrame = s_Elided;
+        s_Calls = 0;
+        s_Elided = 0;
+    }
+
+}
@@ -0,0 +1,49 @@
+#include "rg/GaussianKernel.h"
+#include <algorithm>
+#include <cmath>
+
+namespace rg {
+
+    const unsigned int GaussianKernel::MAX_TAPS;
+    const unsigned int GaussianKernel::MAX_RADIUS;
+
+    GaussianKernel GaussianKernel::make(float sigma) {
+        sigma = std::max(sigma, 0.1f);
+        unsigned int radius = std::min((unsigned int) std::ceil(3.0f * sigma), MAX_RADIUS);
+
+        GaussianKernel kernel;
+        float *discrete = kernel.discreteWeights;
+        float sum = 0.0f;
+        for (unsigned int i = 0; i <= radius; ++i) {
+            discrete[i] = std::exp(-(float) (i * i) / (2.0f * sigma * sigma));
+            sum += i == 0 ? discrete[i] : 2.0f * discrete[i];
+        }
+        for (unsigned int i = 0; i <= MAX_RADIUS; ++i) {
+            discrete[i] = i <= radius ? discrete[i] / sum : 0.0f;
+        }
+
+        kernel.radius = radius;
+        kernel.offsets[0] = 0.0f;
+        kernel.weights[0] = discrete[0];
+        kernel.tapCount = 1;
+        for (unsigned int i = 1; i <= radius; i += 2) {
+            float first = discrete[i];
+            // an odd radius leaves the last texel without a partner
+            float second = i + 1 <= radius ? discrete[i + 1] : 0.0f;
+            float weight = first + second;
+            kernel.offsets[kernel.tapCount] = (i * first + (i + 1) * second) / weight;
+            kernel.weights[kernel.tapCount] = weight;
+            ++kernel.tapCount;
+        }
+        return kernel;
+    }
+
+    unsigned int GaussianKernel::fetchCount() const {
+        return 2 * tapCount - 1;
+    }
+
+    unsigned int GaussianKernel::discreteFetchCount() const {
+        return 2 * radius + 1;
+    }
+
+}
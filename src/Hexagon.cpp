@@ -4,6 +4,7 @@
 
 #include <glad/glad.h>
 #include "rg/Hexagon.h"
+#include "rg/GLState.h"
 #include <iostream>
 
 namespace rg {
@@ -34,7 +35,7 @@ namespace rg {
             };
             setupHexagon2();
         }
-        glBindVertexArray(0);
+        GLState::bindVertexArray(0);
     }
 
     std::vector<float> Hexagon::makeVertexMatrix(std::vector<float> &pos, std::vector<float> &tex) {
@@ -142,7 +143,7 @@ namespace rg {
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
 
-        glBindVertexArray(VAO); // activate VAO
+        GLState::bindVertexArray(VAO); // activate VAO
 
         glBindBuffer(GL_ARRAY_BUFFER, VBO); // activate buffer
         glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), &vertices[0],GL_STATIC_DRAW); // copy user defined data into the current bind buffer
@@ -169,13 +170,13 @@ namespace rg {
         glGenBuffers(1, &VBO);
         glGenBuffers(1, &EBO);
 
-        glBindVertexArray(VAO);
+        GLState::bindVertexArray(VAO);
 
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
         glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), &vertices[0],GL_STATIC_DRAW); // copy user defined data into the current bind buffer
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(float), &indices[0], GL_STATIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(indices[0]), &indices[0], GL_STATIC_DRAW);
 
         // position attribute
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)0);
@@ -189,18 +190,24 @@ namespace rg {
     }
 
     void Hexagon::drawHexagon() {
-        glBindVertexArray(VAO);
+        GLState::bindVertexArray(VAO);
         if (normalMapping) {
             glDrawArrays(GL_TRIANGLES, 0, 6 * 3); // render triangles
         }
         else {
             glDrawElements(GL_TRIANGLES, 3 * 6, GL_UNSIGNED_INT, 0);
         }
-        glBindVertexArray(0);
+    }
+
+    void Hexagon::submitHexagon(RenderQueue &queue, DrawItem item, RenderPass pass, float depth) {
+        item.vao = VAO;
+        item.count = 3 * 6;
+        item.indexed = !normalMapping;
+        queue.submit(item, pass, depth);
     }
 
     void Hexagon::free() {
-        glDeleteVertexArrays(1, &VAO);
+        GLState::deleteVertexArrays(1, &VAO);
         glDeleteBuffers(1, &VBO);
         if (!normalMapping) {
             glDeleteBuffers(1, &EBO);
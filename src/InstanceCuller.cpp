@@ -0,0 +1,94 @@
+#include "rg/InstanceCuller.h"
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+namespace rg {
+
+    InstanceCuller::InstanceCuller(const AABB &bounds)
+            : m_Center(bounds.center()), m_BoundsRadius(glm::length(bounds.extents())) {
+    }
+
+    void InstanceCuller::add(const glm::mat4 &matrix) {
+        if (m_Count == m_X.size()) {
+            m_X.resize(m_Count + 4, 0.0f);
+            m_Y.resize(m_Count + 4, 0.0f);
+            m_Z.resize(m_Count + 4, 0.0f);
+            m_Radius.resize(m_Count + 4, -1.0f);
+        }
+        set(m_Count++, matrix);
+    }
+
+    void InstanceCuller::set(unsigned int index, const glm::mat4 &matrix) {
+        glm::vec3 position = glm::vec3(matrix * glm::vec4(m_Center, 1.0f));
+        float scale = glm::max(glm::length(glm::vec3(matrix[0])),
+                               glm::max(glm::length(glm::vec3(matrix[1])), glm::length(glm::vec3(matrix[2]))));
+        m_X[index] = position.x;
+        m_Y[index] = position.y;
+        m_Z[index] = position.z;
+        m_Radius[index] = m_BoundsRadius * scale;
+    }
+
+    void InstanceCuller::removeSwap(unsigned int index) {
+        unsigned int last = --m_Count;
+        m_X[index] = m_X[last];
+        m_Y[index] = m_Y[last];
+        m_Z[index] = m_Z[last];
+        m_Radius[index] = m_Radius[last];
+        m_Radius[last] = -1.0f;
+    }
+
+    const std::vector<unsigned int> &InstanceCuller::cull(const Frustum &frustum) {
+        m_Visible.clear();
+        unsigned int count = m_Count;
+
+#ifdef __SSE__
+        __m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+        for (unsigned int p = 0; p < 6; ++p) {
+            const glm::vec4 &plane = frustum.getPlane(p);
+            planeX[p] = _mm_set1_ps(plane.x);
+            planeY[p] = _mm_set1_ps(plane.y);
+            planeZ[p] = _mm_set1_ps(plane.z);
+            planeW[p] = _mm_set1_ps(plane.w);
+        }
+        for (unsigned int i = 0; i < count; i += 4) {
+            __m128 x = _mm_loadu_ps(&m_X[i]);
+            __m128 y = _mm_loadu_ps(&m_Y[i]);
+            __m128 z = _mm_loadu_ps(&m_Z[i]);
+            __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&m_Radius[i]));
+            __m128 inside = _mm_setzero_ps();
+            for (unsigned int p = 0; p < 6; ++p) {
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], x), _mm_mul_ps(planeY[p], y)),
+                                             _mm_add_ps(_mm_mul_ps(planeZ[p], z), planeW[p]));
+                __m128 planeInside = _mm_cmpge_ps(distance, negRadius);
+                inside = p == 0 ? planeInside : _mm_and_ps(inside, planeInside);
+            }
+            int mask = _mm_movemask_ps(inside);
+            while (mask) {
+                int lane = __builtin_ctz(mask);
+                mask &= mask - 1;
+                if (i + lane < count) {
+                    m_Visible.push_back(i + lane);
+                }
+            }
+        }
+#else
+        for (unsigned int i = 0; i < count; ++i) {
+            if (frustum.intersects(glm::vec3(m_X[i], m_Y[i], m_Z[i]), m_Radius[i])) {
+                m_Visible.push_back(i);
+            }
+        }
+#endif
+        return m_Visible;
+    }
+
+    unsigned int InstanceCuller::getCount() const {
+        return m_Count;
+    }
+
+    unsigned int InstanceCuller::getVisibleCount() const {
+        return m_Visible.size();
+    }
+
+}
@@ -0,0 +1,447 @@
+#include "rg/InstancedModel.h"
+#include "rg/GLExtensions.h"
+#include "rg/GLState.h"
+#include "rg/Error.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace rg {
+
+    const InstancedModel::InstanceId InstancedModel::INVALID_INSTANCE;
+    const unsigned int InstancedModel::CULL_GROUP_SIZE;
+
+    static const unsigned int MIN_INSTANCE_CAPACITY = 64;
+    // a fence that hasn't signalled after this long is given up on
+    static const GLuint64 FENCE_TIMEOUT_NS = 1000000000;
+
+    InstancedModel::InstancedModel(Model &model, bool persistent, bool gpuCulling)
+            : m_Model(model), m_Culler(model.getBounds()), m_Persistent(persistent && GLExtensions::hasBufferStorage()),
+              m_GpuCulling(gpuCulling && supportsGpuCulling()) {
+        ASSERT(model.isReady(), "Instanced model needs a loaded model");
+        for (const Mesh &mesh: model.meshes) {
+            MeshTextures textures = {};
+            for (const Texture &texture: mesh.textures) {
+                if (texture.type == "texture_diffuse" && textures.textures[0] == 0) {
+                    textures.textures[0] = texture.id;
+                } else if (texture.type == "texture_specular" && textures.textures[1] == 0) {
+                    textures.textures[1] = texture.id;
+                }
+            }
+            // same as the old hand-written loops for meshes without their own diffuse map
+            if (textures.textures[0] == 0 && !model.loaded_textures.empty()) {
+                textures.textures[0] = model.loaded_textures[0].id;
+            }
+            if (textures.textures[1] == 0) {
+                textures.textures[1] = textures.textures[0];
+            }
+            textures.count = 2;
+            m_MeshTextures.push_back(textures);
+        }
+
+        if (m_GpuCulling) {
+            m_CullShader.reset(new Shader("resources/shaders/instanceCull.cs"));
+            m_CommandShader.reset(new Shader("resources/shaders/instanceCommands.cs"));
+            if (!m_CullShader->isLinked() || !m_CommandShader->isLinked()) {
+                std::cerr << "Instance culling programs failed to link, culling on the CPU\n";
+                m_CullShader.reset();
+                m_CommandShader.reset();
+                m_GpuCulling = false;
+            }
+        }
+        if (m_GpuCulling) {
+            m_Persistent = false;
+            AABB bounds = model.getBounds();
+            m_BoundingSphere = glm::vec4(bounds.center(), glm::length(bounds.extents()));
+
+            m_CullInstanceCount = m_CullShader->uniform<int>("instanceCount");
+            m_CullStride = m_CullShader->uniform<int>("stride");
+            m_CullBoundingSphere = m_CullShader->uniform<glm::vec4>("boundingSphere");
+            m_CullPlanes = m_CullShader->uniform<glm::vec4>("planes");
+
+            // instance counts are filled in on the GPU every frame
+            for (const Mesh &mesh: model.meshes) {
+                m_Commands.push_back(DrawElementsIndirectCommand{(GLuint) mesh.indexCount, 0, 0, 0, 0});
+            }
+            glGenBuffers(1, &m_CommandBuffer);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_CommandBuffer);
+            glBufferData(GL_DRAW_INDIRECT_BUFFER, m_Commands.size() * sizeof(DrawElementsIndirectCommand), m_Commands.data(),
+                         GL_DYNAMIC_DRAW);
+            GLuint zero = 0;
+            glGenBuffers(1, &m_CounterBuffer);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_CounterBuffer);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint), &zero, GL_DYNAMIC_DRAW);
+        }
+        allocate(MIN_INSTANCE_CAPACITY);
+    }
+
+    bool InstancedModel::supportsGpuCulling() {
+        return GLExtensions::hasCompute() && GLExtensions::hasShaderStorage() && GLExtensions::hasDrawIndirect();
+    }
+
+    std::size_t InstancedModel::getInstanceSize() const {
+        std::size_t size = sizeof(glm::mat4);
+        for (const Stream &stream: m_Streams) {
+            size += stream.components * sizeof(float);
+        }
+        return size;
+    }
+
+    void InstancedModel::allocate(unsigned int capacity) {
+        if (m_Buffer) {
+            releaseBuffers();
+        }
+        m_Capacity = capacity;
+        std::size_t regionSize = capacity * getInstanceSize();
+
+        if (m_GpuCulling) {
+            glGenBuffers(1, &m_Buffer);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_Buffer);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, regionSize, nullptr, GL_DYNAMIC_DRAW);
+            glGenBuffers(1, &m_CulledBuffer);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_CulledBuffer);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, regionSize, nullptr, GL_DYNAMIC_COPY);
+            // the new buffer starts out empty
+            markDirty(0, m_Matrices.size());
+            m_BoundOffset = -1;
+            return;
+        }
+
+        glGenBuffers(1, &m_Buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, m_Buffer);
+        if (m_Persistent) {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            GLExtensions::bufferStorage(GL_ARRAY_BUFFER, REGIONS * regionSize, nullptr, flags);
+            m_Mapped = (char *) glMapBufferRange(GL_ARRAY_BUFFER, 0, REGIONS * regionSize, flags);
+            if (!m_Mapped) {
+                std::cerr << "Failed to map the instance buffer persistently, falling back to orphaning\n";
+                m_Persistent = false;
+                glDeleteBuffers(1, &m_Buffer);
+                m_Buffer = 0;
+                allocate(capacity);
+                return;
+            }
+        } else {
+            glBufferData(GL_ARRAY_BUFFER, regionSize, nullptr, GL_STREAM_DRAW);
+        }
+        m_BoundOffset = -1;
+    }
+
+    void InstancedModel::bindAttributes(std::size_t offset) {
+        // the compacted records of the GPU path are interleaved, the region written on the CPU has one block per stream
+        glBindBuffer(GL_ARRAY_BUFFER, m_GpuCulling ? m_CulledBuffer : m_Buffer);
+        std::size_t matrixStride = m_GpuCulling ? getInstanceSize() : sizeof(glm::mat4);
+        for (const Mesh &mesh: m_Model.meshes) {
+            for (unsigned int vao: {mesh.VAO, mesh.depthVAO}) {
+                GLState::bindVertexArray(vao);
+                for (unsigned int column = 0; column < 4; ++column) {
+                    glEnableVertexAttribArray(3 + column);
+                    glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, matrixStride,
+                                          (void *) (offset + column * sizeof(glm::vec4)));
+                    glVertexAttribDivisor(3 + column, 1);
+                }
+                // the streams follow the matrices, each packed on its own
+                std::size_t streamOffset = offset + (m_GpuCulling ? sizeof(glm::mat4) : m_Capacity * sizeof(glm::mat4));
+                for (const Stream &stream: m_Streams) {
+                    std::size_t streamSize = stream.components * sizeof(float);
+                    glEnableVertexAttribArray(stream.location);
+                    glVertexAttribPointer(stream.location, stream.components, GL_FLOAT, GL_FALSE,
+                                          m_GpuCulling ? matrixStride : streamSize, (void *) streamOffset);
+                    glVertexAttribDivisor(stream.location, 1);
+                    streamOffset += m_GpuCulling ? streamSize : m_Capacity * streamSize;
+                }
+            }
+        }
+        GLState::bindVertexArray(0);
+        m_BoundOffset = offset;
+    }
+
+    unsigned int InstancedModel::addStream(unsigned int location, unsigned int components) {
+        ASSERT(location > 6 && components >= 1 && components <= 4, "Instance streams go after the matrix, up to 4 floats");
+        Stream stream;
+        stream.location = location;
+        stream.components = components;
+        stream.values.assign(m_Matrices.size() * components, 0.0f);
+        m_Streams.push_back(std::move(stream));
+        // the region layout changed
+        allocate(m_Capacity);
+        return m_Streams.size() - 1;
+    }
+
+    InstancedModel::InstanceId InstancedModel::add(const glm::mat4 &matrix) {
+        InstanceId id;
+        if (!m_FreeIds.empty()) {
+            id = m_FreeIds.back();
+            m_FreeIds.pop_back();
+        } else {
+            id = m_IdSlots.size();
+            m_IdSlots.push_back(INVALID_INSTANCE);
+        }
+        m_IdSlots[id] = m_Matrices.size();
+        m_SlotIds.push_back(id);
+        m_Matrices.push_back(matrix);
+        for (Stream &stream: m_Streams) {
+            stream.values.resize(stream.values.size() + stream.components, 0.0f);
+        }
+        if (!m_GpuCulling) {
+            m_Culler.add(matrix);
+        }
+        markDirty(m_Matrices.size() - 1, m_Matrices.size());
+
+        if (m_Matrices.size() > m_Capacity) {
+            allocate(std::max<unsigned int>(m_Matrices.size(), 2 * m_Capacity));
+        }
+        return id;
+    }
+
+    void InstancedModel::remove(InstanceId id) {
+        ASSERT(id < m_IdSlots.size() && m_IdSlots[id] != INVALID_INSTANCE, "Removing an instance that doesn't exist");
+        unsigned int slot = m_IdSlots[id];
+        unsigned int last = m_Matrices.size() - 1;
+
+        m_Matrices[slot] = m_Matrices[last];
+        m_Matrices.pop_back();
+        for (Stream &stream: m_Streams) {
+            std::copy(stream.values.begin() + last * stream.components, stream.values.begin() + (last + 1) * stream.components,
+                      stream.values.begin() + slot * stream.components);
+            stream.values.resize(last * stream.components);
+        }
+        if (!m_GpuCulling) {
+            m_Culler.removeSwap(slot);
+        }
+        if (slot != last) {
+            markDirty(slot, slot + 1);
+        }
+
+        m_SlotIds[slot] = m_SlotIds[last];
+        m_IdSlots[m_SlotIds[slot]] = slot;
+        m_SlotIds.pop_back();
+        m_IdSlots[id] = INVALID_INSTANCE;
+        m_FreeIds.push_back(id);
+    }
+
+    void InstancedModel::update(InstanceId id, const glm::mat4 &matrix) {
+        unsigned int slot = m_IdSlots[id];
+        m_Matrices[slot] = matrix;
+        if (!m_GpuCulling) {
+            m_Culler.set(slot, matrix);
+        }
+        markDirty(slot, slot + 1);
+    }
+
+    void InstancedModel::setStream(InstanceId id, unsigned int stream, const float *values) {
+        Stream &target = m_Streams[stream];
+        unsigned int slot = m_IdSlots[id];
+        std::memcpy(&target.values[slot * target.components], values, target.components * sizeof(float));
+        markDirty(slot, slot + 1);
+    }
+
+    void InstancedModel::markDirty(unsigned int begin, unsigned int end) {
+        if (!m_GpuCulling || begin >= end) {
+            return;
+        }
+        if (m_DirtyBegin >= m_DirtyEnd) {
+            m_DirtyBegin = begin;
+            m_DirtyEnd = end;
+        } else {
+            m_DirtyBegin = std::min(m_DirtyBegin, begin);
+            m_DirtyEnd = std::max(m_DirtyEnd, end);
+        }
+    }
+
+    void InstancedModel::uploadDirty() {
+        // slots past the end were removed since
+        m_DirtyEnd = std::min<unsigned int>(m_DirtyEnd, m_Matrices.size());
+        if (m_DirtyBegin >= m_DirtyEnd) {
+            m_DirtyBegin = m_DirtyEnd = 0;
+            return;
+        }
+
+        std::size_t instanceSize = getInstanceSize();
+        m_Staging.resize((m_DirtyEnd - m_DirtyBegin) * instanceSize / sizeof(float));
+        float *record = m_Staging.data();
+        for (unsigned int slot = m_DirtyBegin; slot < m_DirtyEnd; ++slot) {
+            std::memcpy(record, &m_Matrices[slot], sizeof(glm::mat4));
+            record += 16;
+            for (const Stream &stream: m_Streams) {
+                std::memcpy(record, &stream.values[slot * stream.components], stream.components * sizeof(float));
+                record += stream.components;
+            }
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_Buffer);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, m_DirtyBegin * instanceSize, m_Staging.size() * sizeof(float), m_Staging.data());
+        m_DirtyBegin = m_DirtyEnd = 0;
+    }
+
+    void InstancedModel::cullOnGpu(const Frustum *frustum) {
+        unsigned int count = m_Matrices.size();
+        GLuint zero = 0;
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_CounterBuffer);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint), &zero);
+
+        // without a frustum every plane lets everything through
+        glm::vec4 planes[6];
+        for (unsigned int p = 0; p < 6; ++p) {
+            planes[p] = frustum ? frustum->getPlane(p) : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        }
+        m_CullShader->use();
+        m_CullInstanceCount.set((int) count);
+        m_CullStride.set((int) (getInstanceSize() / sizeof(float)));
+        m_CullBoundingSphere.set(m_BoundingSphere);
+        glUniform4fv(m_CullPlanes.location(), 6, &planes[0][0]);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_Buffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_CulledBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_CounterBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, m_CommandBuffer);
+        if (count > 0) {
+            GLExtensions::dispatchCompute((count + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+        }
+        GLExtensions::memoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        m_CommandShader->use();
+        GLExtensions::dispatchCompute((m_Commands.size() + 63) / 64, 1, 1);
+        // the draws take their instance counts and matrices from what the two passes wrote
+        GLExtensions::memoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+    }
+
+    void InstancedModel::writeInstances(char *destination, const std::vector<unsigned int> *visible) {
+        glm::mat4 *matrices = (glm::mat4 *) destination;
+        if (visible) {
+            for (unsigned int i = 0; i < m_VisibleCount; ++i) {
+                matrices[i] = m_Matrices[(*visible)[i]];
+            }
+        } else {
+            std::memcpy(matrices, m_Matrices.data(), m_VisibleCount * sizeof(glm::mat4));
+        }
+
+        float *streamValues = (float *) (destination + m_Capacity * sizeof(glm::mat4));
+        for (const Stream &stream: m_Streams) {
+            if (visible) {
+                for (unsigned int i = 0; i < m_VisibleCount; ++i) {
+                    std::memcpy(streamValues + i * stream.components, &stream.values[(*visible)[i] * stream.components],
+                                stream.components * sizeof(float));
+                }
+            } else {
+                std::memcpy(streamValues, stream.values.data(), m_VisibleCount * stream.components * sizeof(float));
+            }
+            streamValues += m_Capacity * stream.components;
+        }
+    }
+
+    unsigned int InstancedModel::prepare(const Frustum *frustum) {
+        if (m_GpuCulling) {
+            uploadDirty();
+            cullOnGpu(frustum);
+            if (m_BoundOffset != 0) {
+                bindAttributes(0);
+            }
+            m_VisibleCount = m_Matrices.size();
+            return m_VisibleCount;
+        }
+
+        const std::vector<unsigned int> *visible = frustum ? &m_Culler.cull(*frustum) : nullptr;
+        m_VisibleCount = visible ? visible->size() : m_Matrices.size();
+        std::size_t regionSize = m_Capacity * getInstanceSize();
+
+        std::size_t offset = 0;
+        if (m_Persistent) {
+            // every command so far, last frame's draws included, is before this fence
+            if (m_Fences[m_Region]) {
+                glDeleteSync(m_Fences[m_Region]);
+            }
+            m_Fences[m_Region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+            m_Region = (m_Region + 1) % REGIONS;
+            if (m_Fences[m_Region]) {
+                glClientWaitSync(m_Fences[m_Region], GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS);
+                glDeleteSync(m_Fences[m_Region]);
+                m_Fences[m_Region] = 0;
+            }
+            offset = m_Region * regionSize;
+            writeInstances(m_Mapped + offset, visible);
+        } else {
+            glBindBuffer(GL_ARRAY_BUFFER, m_Buffer);
+            char *mapped = (char *) glMapBufferRange(GL_ARRAY_BUFFER, 0, regionSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+            if (mapped) {
+                writeInstances(mapped, visible);
+                glUnmapBuffer(GL_ARRAY_BUFFER);
+            }
+        }
+
+        if ((long) offset != m_BoundOffset) {
+            bindAttributes(offset);
+        }
+        return m_VisibleCount;
+    }
+
+    void InstancedModel::Submit(RenderQueue &queue, const DrawItem &item, RenderPass pass, float depth) const {
+        if (m_VisibleCount == 0) {
+            return;
+        }
+        for (unsigned int i = 0; i < m_Model.meshes.size(); ++i) {
+            DrawItem meshItem = item;
+            if (m_GpuCulling) {
+                meshItem.commands = m_Commands.data();
+                meshItem.firstCommand = i;
+                meshItem.drawCount = 1;
+                meshItem.indirectBuffer = m_CommandBuffer;
+            } else {
+                meshItem.instanceCount = m_VisibleCount;
+            }
+            if (meshItem.textureCount == 0) {
+                const MeshTextures &textures = m_MeshTextures[i];
+                std::copy(textures.textures, textures.textures + textures.count, meshItem.textures);
+                meshItem.textureCount = textures.count;
+            }
+            m_Model.meshes[i].Submit(queue, meshItem, pass, depth);
+        }
+    }
+
+    unsigned int InstancedModel::getCount() const {
+        return m_Matrices.size();
+    }
+
+    unsigned int InstancedModel::getVisibleCount() const {
+        return m_VisibleCount;
+    }
+
+    bool InstancedModel::isPersistent() const {
+        return m_Persistent;
+    }
+
+    bool InstancedModel::isGpuCulled() const {
+        return m_GpuCulling;
+    }
+
+    void InstancedModel::releaseBuffers() {
+        for (GLsync &fence: m_Fences) {
+            if (fence) {
+                glDeleteSync(fence);
+                fence = 0;
+            }
+        }
+        if (m_Mapped) {
+            glBindBuffer(GL_ARRAY_BUFFER, m_Buffer);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+            m_Mapped = nullptr;
+        }
+        glDeleteBuffers(1, &m_Buffer);
+        glDeleteBuffers(1, &m_CulledBuffer);
+        m_Buffer = 0;
+        m_CulledBuffer = 0;
+    }
+
+    void InstancedModel::free() {
+        releaseBuffers();
+        glDeleteBuffers(1, &m_CounterBuffer);
+        glDeleteBuffers(1, &m_CommandBuffer);
+        m_CounterBuffer = 0;
+        m_CommandBuffer = 0;
+        if (m_GpuCulling) {
+            m_CullShader->deleteProgram();
+            m_CommandShader->deleteProgram();
+        }
+    }
+
+}
@@ -0,0 +1,72 @@
+#include "rg/Material.h"
+#include "rg/GLState.h"
+#include "rg/Error.h"
+
+#include <utility>
+
+namespace rg {
+
+    Material::Material(const std::vector<Texture> &textures) {
+        unsigned int diffuseNr = 1;
+        unsigned int specularNr = 1;
+        unsigned int normalNr = 1;
+        unsigned int heightNr = 1;
+
+        m_Bindings.reserve(textures.size());
+        for (const Texture &texture: textures) {
+            unsigned int number = 0;
+            if (texture.type == "texture_diffuse") {
+                number = diffuseNr++;
+            } else if (texture.type == "texture_specular") {
+                number = specularNr++;
+            } else if (texture.type == "texture_normal") {
+                number = normalNr++;
+            } else if (texture.type == "texture_height") {
+                number = heightNr++;
+            } else {
+                ASSERT(false, "Unknown texture type");
+            }
+            m_Bindings.push_back(Binding{texture.id, texture.type + std::to_string(number)});
+        }
+    }
+
+    const std::vector<int> &Material::locationsFor(const Shader &shader) {
+        unsigned int program = shader.getId();
+        for (const ProgramSamplers &samplers: m_Programs) {
+            if (samplers.program == program) {
+                return samplers.locations;
+            }
+        }
+
+        ProgramSamplers samplers;
+        samplers.program = program;
+        for (const Binding &binding: m_Bindings) {
+            samplers.locations.push_back(shader.getUniformLocation(binding.sampler));
+        }
+        m_Programs.push_back(std::move(samplers));
+        return m_Programs.back().locations;
+    }
+
+    void Material::bind(const Shader &shader) {
+        const std::vector<int> &locations = locationsFor(shader);
+        for (unsigned int unit = 0; unit < m_Bindings.size(); ++unit) {
+            if (locations[unit] != -1) {
+                setUniform(locations[unit], (int) unit);
+            }
+            GLState::bindTexture(unit, m_Bindings[unit].texture);
+        }
+    }
+
+    void Material::fill(DrawItem &item) const {
+        item.textureCount = 0;
+        for (unsigned int unit = 0; unit < m_Bindings.size() && unit < MAX_DRAW_TEXTURES; ++unit) {
+            item.textures[unit] = m_Bindings[unit].texture;
+            ++item.textureCount;
+        }
+    }
+
+    unsigned int Material::getTextureCount() const {
+        return m_Bindings.size();
+    }
+
+}
@@ -4,80 +4,192 @@
 
 #include "rg/Mesh.h"
 #include "rg/Error.h"
+#include "rg/GLState.h"
+
+#include <utility>
 
 namespace rg {
 
-    Mesh::Mesh(const std::vector<Vertex> &vs, const std::vector<unsigned int> &ind, const std::vector<Texture> &tex)
-            : vertices(vs), indices(ind), textures(tex) {
-        setupMesh();
+    GLenum indexTypeFor(std::size_t vertexCount) {
+        if (vertexCount <= 0x100) {
+            return GL_UNSIGNED_BYTE;
+        }
+        if (vertexCount <= 0x10000) {
+            return GL_UNSIGNED_SHORT;
+        }
+        return GL_UNSIGNED_INT;
     }
 
-    void Mesh::Draw(Shader &shader) {
-        unsigned int diffuseNr = 1;
-        unsigned int specularNr = 1;
-        unsigned int normalNr = 1;
-        unsigned int heightNr = 1;
-
-        for (unsigned int i = 0; i < textures.size(); ++i) {
-            glActiveTexture(GL_TEXTURE0 + i);
-            std::string name = textures[i].type;
-            std::string number;
-
-            if (name == "texture_diffuse") {
-                number = std::to_string(diffuseNr++); // 1
-            } else if (name == "texture_specular") {
-                number = std::to_string(specularNr++);
-            } else if (name == "texture_normal") {
-                number = std::to_string(normalNr++);
-            } else if (name == "texture_height") {
-                number = std::to_string(heightNr++);
-            } else {
-                ASSERT(false, "Unknown texture type");
+    std::size_t indexTypeSize(GLenum indexType) {
+        switch (indexType) {
+            case GL_UNSIGNED_BYTE:
+                return 1;
+            case GL_UNSIGNED_SHORT:
+                return 2;
+            default:
+                return 4;
+        }
+    }
+
+    void setVertexAttributes(VertexFormat format, bool positionOnly) {
+        if (format == VERTEX_PACKED) {
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void *) (offsetof(PackedVertex, Position)));
+            if (positionOnly) {
+                return;
+            }
+
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex), (void *) (offsetof(PackedVertex, Normal)));
+
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), (void *) (offsetof(PackedVertex, TexCoords)));
+
+            glEnableVertexAttribArray(3);
+            glVertexAttribPointer(3, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex), (void *) (offsetof(PackedVertex, Tangent)));
+        } else {
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *) (offsetof(Vertex, Position)));
+            if (positionOnly) {
+                return;
             }
-            name.append(number);
-            shader.setInt(name, i); // texture_diffuse1
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *) (offsetof(Vertex, Normal)));
+
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *) (offsetof(Vertex, TexCoords)));
+
+            glEnableVertexAttribArray(3);
+            glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *) (offsetof(Vertex, Tangent)));
+
+            glEnableVertexAttribArray(4);
+            glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *) (offsetof(Vertex, Bitangent)));
         }
+    }
 
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+    Mesh::Mesh(std::vector<Vertex> vs, std::vector<unsigned int> ind, const std::vector<Texture> &tex,
+               VertexFormat vertexFormat, bool keepGeometry)
+            : m_PositionDecode(1.0f), m_Material(tex), vertices(std::move(vs)), indices(std::move(ind)), textures(tex), format(vertexFormat),
+              indexType(GL_UNSIGNED_INT), vertexCount(vertices.size()), indexCount(indices.size()) {
+        setupMesh(vertices.data(), indices.data(), nullptr, AABB());
+        if (!keepGeometry) {
+            std::vector<Vertex>().swap(vertices);
+            std::vector<unsigned int>().swap(indices);
+        }
+    }
 
-        glBindVertexArray(0);
-        glActiveTexture(GL_TEXTURE0);
+    Mesh::Mesh(const Vertex *vs, std::size_t vertexCount, const unsigned int *ind, std::size_t indexCount, const std::vector<Texture> &tex,
+               VertexFormat vertexFormat, bool keepGeometry, const PackedVertex *packed, const AABB &packedBounds)
+            : m_PositionDecode(1.0f), m_Material(tex), textures(tex), format(vertexFormat),
+              indexType(GL_UNSIGNED_INT), vertexCount(vertexCount), indexCount(indexCount) {
+        if (keepGeometry) {
+            vertices.assign(vs, vs + vertexCount);
+            indices.assign(ind, ind + indexCount);
+        }
+        setupMesh(vs, ind, packed, packedBounds);
     }
 
-    void Mesh::setupMesh() {
-        unsigned int VBO;
-        unsigned int EBO;
+    void Mesh::Draw(Shader &shader) {
+        ASSERT(format == VERTEX_FULL, "Mesh::Draw can't decode packed positions, submit the mesh instead");
+        m_Material.bind(shader);
+        GLState::bindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, indexCount, indexType, 0);
+    }
 
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
+    void Mesh::Submit(RenderQueue &queue, DrawItem item, RenderPass pass, float depth) const {
+        item.vao = VAO;
+        item.count = indexCount;
+        item.indexed = true;
+        item.indexType = indexType;
+        if (format == VERTEX_PACKED) {
+            item.model = item.model * m_PositionDecode;
+        }
+        if (pass == PASS_DEPTH) {
+            item.vao = depthVAO;
+            item.textureCount = 0;
+        } else if (item.textureCount == 0) {
+            m_Material.fill(item);
+        }
+        queue.submit(item, pass, depth);
+    }
 
-        glBindVertexArray(VAO);
+    std::size_t Mesh::getVertexBufferSize() const {
+        return vertexCount * (format == VERTEX_PACKED ? sizeof(PackedVertex) : sizeof(Vertex));
+    }
 
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+    std::size_t Mesh::getIndexBufferSize() const {
+        return indexCount * indexTypeSize(indexType);
+    }
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(indices[0]), &indices[0], GL_STATIC_DRAW);
+    std::size_t Mesh::getResidentSize() const {
+        return vertices.capacity() * sizeof(Vertex) + indices.capacity() * sizeof(unsigned int) +
+               textures.capacity() * sizeof(Texture);
+    }
 
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *) (offsetof(Vertex, Position)));
+    const glm::mat4 &Mesh::getPositionDecode() const {
+        return m_PositionDecode;
+    }
 
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *) (offsetof(Vertex, Normal)));
+    const Material &Mesh::getMaterial() const {
+        return m_Material;
+    }
 
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *) (offsetof(Vertex, TexCoords)));
+    // indices narrowed to T, the caller made sure every index fits
+    template<typename T>
+    static void uploadIndices(const unsigned int *indices, std::size_t indexCount) {
+        std::vector<T> narrow(indices, indices + indexCount);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, narrow.size() * sizeof(T), narrow.data(), GL_STATIC_DRAW);
+    }
 
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *) (offsetof(Vertex, Tangent)));
+    void Mesh::setupMesh(const Vertex *vs, const unsigned int *ind, const PackedVertex *packed, const AABB &packedBounds) {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+
+        GLState::bindVertexArray(VAO);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        indexType = indexTypeFor(vertexCount);
+        if (indexType == GL_UNSIGNED_BYTE) {
+            uploadIndices<GLubyte>(ind, indexCount);
+        } else if (indexType == GL_UNSIGNED_SHORT) {
+            uploadIndices<GLushort>(ind, indexCount);
+        } else {
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), ind, GL_STATIC_DRAW);
+        }
 
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *) (offsetof(Vertex, Bitangent)));
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        if (format == VERTEX_PACKED) {
+            AABB box = packedBounds;
+            std::vector<PackedVertex> converted;
+            if (!packed) {
+                // quantized against the bounds of exactly these vertices
+                if (vertexCount > 0) {
+                    box.min = box.max = vs[0].Position;
+                }
+                for (std::size_t i = 0; i < vertexCount; ++i) {
+                    box.expand(vs[i].Position);
+                }
+                converted.reserve(vertexCount);
+                for (std::size_t i = 0; i < vertexCount; ++i) {
+                    converted.push_back(packVertex(vs[i], box));
+                }
+                packed = converted.data();
+            }
+            m_PositionDecode = packedPositionDecode(box);
+            glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(PackedVertex), packed, GL_STATIC_DRAW);
+        } else {
+            glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(Vertex), vs, GL_STATIC_DRAW);
+        }
+        setVertexAttributes(format);
+
+        glGenVertexArrays(1, &depthVAO);
+        GLState::bindVertexArray(depthVAO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        setVertexAttributes(format, true);
 
-        glBindVertexArray(0);
+        GLState::bindVertexArray(0);
     }
 
 }
\ No newline at end of file
@@ -0,0 +1,313 @@
+#include "rg/MeshCache.h"
+#include "rg/Error.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace rg {
+
+    // bump whenever the layout below, rg::Vertex, rg::PackedVertex, packVertex, the Assimp post-processing flags
+    // or the mesh optimisation change
+    static const std::uint32_t MESH_CACHE_VERSION = 4;
+    static const char MESH_CACHE_MAGIC[4] = {'R', 'G', 'M', 'C'};
+
+    struct CacheHeader {
+        char magic[4];
+        std::uint32_t version;
+        std::uint64_t sourceHash;
+        std::uint32_t vertexSize;
+        std::uint32_t meshCount;
+        std::uint32_t textureCount;
+        std::uint32_t textureIndexCount;
+        std::uint32_t stringBytes;
+        std::uint32_t packedVertexSize;
+    };
+
+    struct CacheTexture {
+        std::uint32_t typeOffset;
+        std::uint32_t typeLength;
+        std::uint32_t pathOffset;
+        std::uint32_t pathLength;
+    };
+
+    struct CacheMesh {
+        std::uint64_t vertexOffset;
+        std::uint64_t packedVertexOffset;
+        std::uint64_t indexOffset;
+        std::uint32_t vertexCount;
+        std::uint32_t indexCount;
+        std::uint32_t textureFirst;
+        std::uint32_t textureCount;
+        float boundsMin[3];
+        float boundsMax[3];
+    };
+
+    static std::size_t alignTo(std::size_t offset, std::size_t alignment) {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    static void hashBytes(std::uint64_t &hash, const char *data, std::size_t size) {
+        // FNV-1a
+        for (std::size_t i = 0; i < size; ++i) {
+            hash ^= (unsigned char) data[i];
+            hash *= 1099511628211ull;
+        }
+    }
+
+    static void hashFile(std::uint64_t &hash, const std::string &path) {
+        std::ifstream in(path, std::ios::binary);
+        char buffer[1 << 16];
+        while (in) {
+            in.read(buffer, sizeof(buffer));
+            hashBytes(hash, buffer, in.gcount());
+        }
+    }
+
+    MeshCache::~MeshCache() {
+        close();
+    }
+
+    void MeshCache::close() {
+        if (m_Mapping) {
+            munmap(m_Mapping, m_Size);
+        }
+        m_Mapping = nullptr;
+        m_Size = 0;
+        m_Meshes = nullptr;
+        m_MeshCount = 0;
+        m_Textures.clear();
+    }
+
+    bool MeshCache::open(const std::string &cachePath, std::uint64_t sourceHash) {
+        close();
+
+        int fd = ::open(cachePath.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || (std::size_t) info.st_size < sizeof(CacheHeader)) {
+            ::close(fd);
+            return false;
+        }
+        m_Size = info.st_size;
+        m_Mapping = mmap(NULL, m_Size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (m_Mapping == MAP_FAILED) {
+            m_Mapping = nullptr;
+            m_Size = 0;
+            return false;
+        }
+
+        const char *base = (const char *) m_Mapping;
+        const CacheHeader *header = (const CacheHeader *) base;
+        if (std::memcmp(header->magic, MESH_CACHE_MAGIC, 4) != 0 || header->version != MESH_CACHE_VERSION ||
+            header->sourceHash != sourceHash || header->vertexSize != sizeof(Vertex) ||
+            header->packedVertexSize != sizeof(PackedVertex)) {
+            close();
+            return false;
+        }
+
+        std::size_t texturesOffset = sizeof(CacheHeader);
+        std::size_t meshesOffset = texturesOffset + header->textureCount * sizeof(CacheTexture);
+        std::size_t textureIndicesOffset = meshesOffset + header->meshCount * sizeof(CacheMesh);
+        std::size_t stringsOffset = textureIndicesOffset + header->textureIndexCount * sizeof(std::uint32_t);
+        if (stringsOffset + header->stringBytes > m_Size) {
+            close();
+            return false;
+        }
+
+        const CacheTexture *textures = (const CacheTexture *) (base + texturesOffset);
+        const char *strings = base + stringsOffset;
+        for (unsigned int i = 0; i < header->textureCount; ++i) {
+            const CacheTexture &entry = textures[i];
+            if (entry.typeOffset + entry.typeLength > header->stringBytes ||
+                entry.pathOffset + entry.pathLength > header->stringBytes) {
+                close();
+                return false;
+            }
+            Texture texture;
+            texture.id = 0;
+            texture.type.assign(strings + entry.typeOffset, entry.typeLength);
+            texture.path.assign(strings + entry.pathOffset, entry.pathLength);
+            m_Textures.push_back(texture);
+        }
+
+        const CacheMesh *meshes = (const CacheMesh *) (base + meshesOffset);
+        const std::uint32_t *textureIndices = (const std::uint32_t *) (base + textureIndicesOffset);
+        for (unsigned int i = 0; i < header->meshCount; ++i) {
+            const CacheMesh &mesh = meshes[i];
+            bool valid = mesh.vertexOffset + (std::uint64_t) mesh.vertexCount * sizeof(Vertex) <= m_Size &&
+                         mesh.packedVertexOffset + (std::uint64_t) mesh.vertexCount * sizeof(PackedVertex) <= m_Size &&
+                         mesh.indexOffset + (std::uint64_t) mesh.indexCount * sizeof(unsigned int) <= m_Size &&
+                         mesh.textureFirst + mesh.textureCount <= header->textureIndexCount;
+            for (unsigned int j = 0; valid && j < mesh.textureCount; ++j) {
+                valid = textureIndices[mesh.textureFirst + j] < header->textureCount;
+            }
+            if (!valid) {
+                close();
+                return false;
+            }
+        }
+
+        m_Meshes = base + meshesOffset;
+        m_MeshCount = header->meshCount;
+        return true;
+    }
+
+    unsigned int MeshCache::getMeshCount() const {
+        return m_MeshCount;
+    }
+
+    MeshCache::MeshView MeshCache::getMesh(unsigned int i) const {
+        const char *base = (const char *) m_Mapping;
+        const CacheHeader *header = (const CacheHeader *) base;
+        const CacheMesh &mesh = ((const CacheMesh *) m_Meshes)[i];
+        const std::uint32_t *textureIndices = (const std::uint32_t *) (m_Meshes + header->meshCount * sizeof(CacheMesh));
+
+        MeshView view;
+        view.vertices = (const Vertex *) (base + mesh.vertexOffset);
+        view.packedVertices = (const PackedVertex *) (base + mesh.packedVertexOffset);
+        view.vertexCount = mesh.vertexCount;
+        view.indices = (const unsigned int *) (base + mesh.indexOffset);
+        view.indexCount = mesh.indexCount;
+        view.textures = textureIndices + mesh.textureFirst;
+        view.textureCount = mesh.textureCount;
+        view.bounds.min = glm::vec3(mesh.boundsMin[0], mesh.boundsMin[1], mesh.boundsMin[2]);
+        view.bounds.max = glm::vec3(mesh.boundsMax[0], mesh.boundsMax[1], mesh.boundsMax[2]);
+        return view;
+    }
+
+    const std::vector<Texture> &MeshCache::getTextures() const {
+        return m_Textures;
+    }
+
+    bool MeshCache::write(const std::string &cachePath, std::uint64_t sourceHash, const ModelData &data) {
+        CacheHeader header;
+        std::memcpy(header.magic, MESH_CACHE_MAGIC, 4);
+        header.version = MESH_CACHE_VERSION;
+        header.sourceHash = sourceHash;
+        header.vertexSize = sizeof(Vertex);
+        header.meshCount = data.meshes.size();
+        header.textureCount = data.textures.size();
+        header.textureIndexCount = 0;
+        header.packedVertexSize = sizeof(PackedVertex);
+
+        std::string strings;
+        std::vector<CacheTexture> textures;
+        for (const Texture &texture: data.textures) {
+            CacheTexture entry;
+            entry.typeOffset = strings.size();
+            entry.typeLength = texture.type.size();
+            strings += texture.type;
+            entry.pathOffset = strings.size();
+            entry.pathLength = texture.path.size();
+            strings += texture.path;
+            textures.push_back(entry);
+        }
+        header.stringBytes = strings.size();
+
+        std::vector<std::uint32_t> textureIndices;
+        std::vector<CacheMesh> meshes;
+        for (const MeshData &mesh: data.meshes) {
+            CacheMesh entry;
+            entry.vertexCount = mesh.vertices.size();
+            entry.indexCount = mesh.indices.size();
+            entry.textureFirst = textureIndices.size();
+            entry.textureCount = mesh.textures.size();
+            for (int i = 0; i < 3; ++i) {
+                entry.boundsMin[i] = mesh.bounds.min[i];
+                entry.boundsMax[i] = mesh.bounds.max[i];
+            }
+            textureIndices.insert(textureIndices.end(), mesh.textures.begin(), mesh.textures.end());
+            meshes.push_back(entry);
+        }
+        header.textureIndexCount = textureIndices.size();
+
+        // geometry starts after the tables, every array aligned to 16 bytes
+        std::size_t offset = sizeof(CacheHeader) + textures.size() * sizeof(CacheTexture) +
+                             meshes.size() * sizeof(CacheMesh) + textureIndices.size() * sizeof(std::uint32_t) +
+                             strings.size();
+        for (CacheMesh &entry: meshes) {
+            offset = alignTo(offset, 16);
+            entry.vertexOffset = offset;
+            offset += entry.vertexCount * sizeof(Vertex);
+            offset = alignTo(offset, 16);
+            entry.packedVertexOffset = offset;
+            offset += entry.vertexCount * sizeof(PackedVertex);
+            offset = alignTo(offset, 16);
+            entry.indexOffset = offset;
+            offset += entry.indexCount * sizeof(unsigned int);
+        }
+
+        std::vector<char> file(offset, 0);
+        char *out = file.data();
+        std::memcpy(out, &header, sizeof(header));
+        out += sizeof(header);
+        std::memcpy(out, textures.data(), textures.size() * sizeof(CacheTexture));
+        out += textures.size() * sizeof(CacheTexture);
+        std::memcpy(out, meshes.data(), meshes.size() * sizeof(CacheMesh));
+        out += meshes.size() * sizeof(CacheMesh);
+        std::memcpy(out, textureIndices.data(), textureIndices.size() * sizeof(std::uint32_t));
+        out += textureIndices.size() * sizeof(std::uint32_t);
+        std::memcpy(out, strings.data(), strings.size());
+        for (std::size_t i = 0; i < meshes.size(); ++i) {
+            const MeshData &mesh = data.meshes[i];
+            std::memcpy(file.data() + meshes[i].vertexOffset, mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex));
+            // packed once here against the importer's bounds, the same box Mesh would quantize against
+            PackedVertex *packed = (PackedVertex *) (file.data() + meshes[i].packedVertexOffset);
+            for (std::size_t j = 0; j < mesh.vertices.size(); ++j) {
+                packed[j] = packVertex(mesh.vertices[j], mesh.bounds);
+            }
+            std::memcpy(file.data() + meshes[i].indexOffset, mesh.indices.data(), mesh.indices.size() * sizeof(unsigned int));
+        }
+
+        // write next to the target and rename, so a crash never leaves a half written cache behind
+        std::string tmpPath = cachePath + ".tmp";
+        {
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            out.write(file.data(), file.size());
+            if (!out) {
+                std::remove(tmpPath.c_str());
+                return false;
+            }
+        }
+        return std::rename(tmpPath.c_str(), cachePath.c_str()) == 0;
+    }
+
+    std::uint64_t MeshCache::hashSource(const std::string &modelPath) {
+        std::uint64_t hash = 14695981039346656037ull;
+        hashFile(hash, modelPath);
+
+        std::string directory = modelPath.substr(0, modelPath.find_last_of('/'));
+        std::vector<std::string> buffers;
+        if (DIR *dir = opendir(directory.c_str())) {
+            while (dirent *entry = readdir(dir)) {
+                std::string name = entry->d_name;
+                if (name.size() > 4 && name.compare(name.size() - 4, 4, ".bin") == 0) {
+                    buffers.push_back(name);
+                }
+            }
+            closedir(dir);
+        }
+        std::sort(buffers.begin(), buffers.end());
+        for (const std::string &name: buffers) {
+            hashBytes(hash, name.c_str(), name.size());
+            hashFile(hash, directory + "/" + name);
+        }
+        return hash;
+    }
+
+    std::string MeshCache::pathFor(const std::string &modelPath) {
+        return modelPath + ".rgcache";
+    }
+
+}
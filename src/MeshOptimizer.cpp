@@ -0,0 +1,285 @@
+#include "rg/MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace rg {
+
+    // tuned for a 32 entry LRU cache, good on FIFO caches of other sizes as well
+    static const unsigned int OPTIMIZE_CACHE_SIZE = 32;
+    static const float CACHE_DECAY_POWER = 1.5f;
+    static const float LAST_TRIANGLE_SCORE = 0.75f;
+    static const float VALENCE_BOOST_SCALE = 2.0f;
+    static const float VALENCE_BOOST_POWER = 0.5f;
+
+    static const unsigned int OVERDRAW_CACHE_SIZE = 16;
+    static const unsigned int UNUSED = 0xffffffffu;
+
+    static float vertexScore(int cachePosition, unsigned int remaining) {
+        if (remaining == 0) {
+            return -1.0f;
+        }
+        float score = 0.0f;
+        if (cachePosition >= 0) {
+            if (cachePosition < 3) {
+                // the triangle just drawn, fixed so that its edges aren't favoured over the rest of the cache
+                score = LAST_TRIANGLE_SCORE;
+            } else {
+                score = std::pow(1.0f - (cachePosition - 3) / (float) (OPTIMIZE_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+            }
+        }
+        // vertices with few triangles left are finished off before they drop out of the cache
+        return score + VALENCE_BOOST_SCALE * std::pow((float) remaining, -VALENCE_BOOST_POWER);
+    }
+
+    VertexCacheStats analyzeVertexCache(const unsigned int *indices, std::size_t indexCount, std::size_t vertexCount,
+                                        unsigned int cacheSize) {
+        VertexCacheStats stats;
+        stats.triangles = indexCount / 3;
+        stats.vertices = vertexCount;
+
+        // a vertex is in the FIFO if it went in less than cacheSize insertions ago
+        std::vector<std::size_t> insertedAt(vertexCount, 0);
+        std::size_t time = cacheSize + 1;
+        for (std::size_t i = 0; i < indexCount; ++i) {
+            unsigned int index = indices[i];
+            if (time - insertedAt[index] > cacheSize) {
+                insertedAt[index] = time++;
+                ++stats.transforms;
+            }
+        }
+
+        if (stats.triangles > 0) {
+            stats.acmr = (float) stats.transforms / stats.triangles;
+        }
+        if (stats.vertices > 0) {
+            stats.atvr = (float) stats.transforms / stats.vertices;
+        }
+        return stats;
+    }
+
+    void optimizeVertexCache(std::vector<unsigned int> &indices, std::size_t vertexCount) {
+        std::size_t triangleCount = indices.size() / 3;
+        if (triangleCount == 0) {
+            return;
+        }
+
+        // triangles of vertex v not emitted yet: adjacency[offsets[v] .. offsets[v] + remaining[v])
+        std::vector<unsigned int> remaining(vertexCount, 0);
+        for (std::size_t i = 0; i < triangleCount * 3; ++i) {
+            ++remaining[indices[i]];
+        }
+        std::vector<unsigned int> offsets(vertexCount + 1, 0);
+        for (std::size_t v = 0; v < vertexCount; ++v) {
+            offsets[v + 1] = offsets[v] + remaining[v];
+        }
+        std::vector<unsigned int> adjacency(triangleCount * 3);
+        {
+            std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+            for (std::size_t i = 0; i < triangleCount * 3; ++i) {
+                adjacency[fill[indices[i]]++] = i / 3;
+            }
+        }
+
+        std::vector<int> cachePosition(vertexCount, -1);
+        std::vector<float> vertexScores(vertexCount);
+        for (std::size_t v = 0; v < vertexCount; ++v) {
+            vertexScores[v] = vertexScore(-1, remaining[v]);
+        }
+
+        std::vector<bool> emitted(triangleCount, false);
+        int best = 0;
+        float bestScore = -1.0f;
+        for (std::size_t t = 0; t < triangleCount; ++t) {
+            float score = vertexScores[indices[3 * t]] + vertexScores[indices[3 * t + 1]] + vertexScores[indices[3 * t + 2]];
+            if (score > bestScore) {
+                bestScore = score;
+                best = t;
+            }
+        }
+
+        std::vector<unsigned int> result;
+        result.reserve(triangleCount * 3);
+        unsigned int cache[OPTIMIZE_CACHE_SIZE + 3];
+        unsigned int cacheCount = 0;
+        std::size_t deadEnd = 0;
+
+        while (best >= 0) {
+            emitted[best] = true;
+            const unsigned int *triangle = &indices[3 * best];
+            unsigned int newCache[OPTIMIZE_CACHE_SIZE + 3];
+            unsigned int newCount = 0;
+
+            for (unsigned int k = 0; k < 3; ++k) {
+                unsigned int v = triangle[k];
+                result.push_back(v);
+
+                unsigned int *begin = &adjacency[offsets[v]];
+                unsigned int *end = begin + remaining[v];
+                unsigned int *found = std::find(begin, end, (unsigned int) best);
+                *found = *(end - 1);
+                --remaining[v];
+
+                if (std::find(newCache, newCache + newCount, v) == newCache + newCount) {
+                    newCache[newCount++] = v;
+                }
+            }
+            // the triangle goes to the front, the rest of the cache moves back
+            for (unsigned int i = 0; i < cacheCount; ++i) {
+                unsigned int v = cache[i];
+                if (std::find(triangle, triangle + 3, v) == triangle + 3) {
+                    newCache[newCount++] = v;
+                }
+            }
+
+            for (unsigned int i = 0; i < newCount; ++i) {
+                unsigned int v = newCache[i];
+                cachePosition[v] = i < OPTIMIZE_CACHE_SIZE ? (int) i : -1;
+                vertexScores[v] = vertexScore(cachePosition[v], remaining[v]);
+            }
+            cacheCount = std::min(newCount, OPTIMIZE_CACHE_SIZE);
+            std::copy(newCache, newCache + cacheCount, cache);
+
+            // only triangles around vertices whose score changed can be the next best
+            best = -1;
+            bestScore = -1.0f;
+            for (unsigned int i = 0; i < newCount; ++i) {
+                unsigned int v = newCache[i];
+                for (unsigned int j = offsets[v]; j < offsets[v] + remaining[v]; ++j) {
+                    unsigned int t = adjacency[j];
+                    float score = vertexScores[indices[3 * t]] + vertexScores[indices[3 * t + 1]] + vertexScores[indices[3 * t + 2]];
+                    if (score > bestScore) {
+                        bestScore = score;
+                        best = t;
+                    }
+                }
+            }
+
+            if (best < 0) {
+                // nothing left around the cache, go on with the first triangle in source order
+                while (deadEnd < triangleCount && emitted[deadEnd]) {
+                    ++deadEnd;
+                }
+                best = deadEnd < triangleCount ? (int) deadEnd : -1;
+            }
+        }
+
+        indices.swap(result);
+    }
+
+    void optimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<Vertex> &vertices) {
+        std::size_t triangleCount = indices.size() / 3;
+        if (triangleCount < 2) {
+            return;
+        }
+
+        // a cluster starts at every triangle whose three vertices all miss the cache,
+        // so moving clusters around costs next to nothing in vertex reuse
+        std::vector<std::size_t> clusterStarts;
+        std::vector<std::size_t> insertedAt(vertices.size(), 0);
+        std::size_t time = OVERDRAW_CACHE_SIZE + 1;
+        for (std::size_t t = 0; t < triangleCount; ++t) {
+            unsigned int misses = 0;
+            for (unsigned int k = 0; k < 3; ++k) {
+                unsigned int index = indices[3 * t + k];
+                if (time - insertedAt[index] > OVERDRAW_CACHE_SIZE) {
+                    insertedAt[index] = time++;
+                    ++misses;
+                }
+            }
+            if (t == 0 || misses == 3) {
+                clusterStarts.push_back(t);
+            }
+        }
+        clusterStarts.push_back(triangleCount);
+        std::size_t clusterCount = clusterStarts.size() - 1;
+        if (clusterCount < 2) {
+            return;
+        }
+
+        // area weighted centroid and normal of every cluster and of the whole mesh
+        std::vector<glm::vec3> centroids(clusterCount, glm::vec3(0.0f));
+        std::vector<glm::vec3> normals(clusterCount, glm::vec3(0.0f));
+        std::vector<float> areas(clusterCount, 0.0f);
+        glm::vec3 meshCentroid(0.0f);
+        float meshArea = 0.0f;
+        for (std::size_t c = 0; c < clusterCount; ++c) {
+            for (std::size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; ++t) {
+                const glm::vec3 &a = vertices[indices[3 * t]].Position;
+                const glm::vec3 &b = vertices[indices[3 * t + 1]].Position;
+                const glm::vec3 &d = vertices[indices[3 * t + 2]].Position;
+                glm::vec3 normal = glm::cross(b - a, d - a);
+                float area = glm::length(normal);
+                centroids[c] += (a + b + d) * (area / 3.0f);
+                normals[c] += normal;
+                areas[c] += area;
+            }
+            meshCentroid += centroids[c];
+            meshArea += areas[c];
+            if (areas[c] > 0.0f) {
+                centroids[c] = centroids[c] / areas[c];
+            }
+        }
+        if (meshArea > 0.0f) {
+            meshCentroid = meshCentroid / meshArea;
+        }
+
+        std::vector<float> keys(clusterCount, 0.0f);
+        for (std::size_t c = 0; c < clusterCount; ++c) {
+            float length = glm::length(normals[c]);
+            if (length > 0.0f) {
+                keys[c] = glm::dot(centroids[c] - meshCentroid, normals[c] / length);
+            }
+        }
+        std::vector<std::size_t> order(clusterCount);
+        for (std::size_t c = 0; c < clusterCount; ++c) {
+            order[c] = c;
+        }
+        std::stable_sort(order.begin(), order.end(), [&keys](std::size_t a, std::size_t b) {
+            return keys[a] > keys[b];
+        });
+
+        std::vector<unsigned int> result;
+        result.reserve(indices.size());
+        for (std::size_t c: order) {
+            result.insert(result.end(), indices.begin() + 3 * clusterStarts[c], indices.begin() + 3 * clusterStarts[c + 1]);
+        }
+        indices.swap(result);
+    }
+
+    void optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices) {
+        std::vector<unsigned int> remap(vertices.size(), UNUSED);
+        std::vector<Vertex> reordered;
+        reordered.reserve(vertices.size());
+        for (unsigned int &index: indices) {
+            if (remap[index] == UNUSED) {
+                remap[index] = reordered.size();
+                reordered.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+        vertices.swap(reordered);
+    }
+
+    void optimizeMesh(MeshData &mesh, bool sortForOverdraw, VertexCacheStats *before, VertexCacheStats *after) {
+        if (before) {
+            *before = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+        }
+        if (mesh.indices.size() % 3 != 0) {
+            // points or lines, nothing to reorder
+            if (after && before) {
+                *after = *before;
+            }
+            return;
+        }
+        optimizeVertexCache(mesh.indices, mesh.vertices.size());
+        if (sortForOverdraw) {
+            optimizeOverdraw(mesh.indices, mesh.vertices);
+        }
+        optimizeVertexFetch(mesh.vertices, mesh.indices);
+        if (after) {
+            *after = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+        }
+    }
+
+}
@@ -3,21 +3,122 @@
 //
 
 #include "rg/Model.h"
+#include "rg/MeshCache.h"
+#include "rg/MeshOptimizer.h"
 #include "rg/Error.h"
 
+#include <cstdio>
+#include <utility>
+
 namespace rg {
 
-    Model::Model(std::string path) {
-        loadModel(path);
+    Model::Model()
+            : m_TextureLoader(nullptr), m_VertexFormat(VERTEX_FULL), m_KeepGeometry(false), m_Ready(false) {
+    }
+
+    Model::Model(std::string path, TextureLoader *textureLoader, bool useCache, VertexFormat vertexFormat, bool keepGeometry)
+            : m_TextureLoader(textureLoader), m_VertexFormat(vertexFormat), m_KeepGeometry(keepGeometry), m_Ready(false) {
+        loadModel(path, useCache);
+        m_Ready = true;
+    }
+
+    bool Model::isReady() const {
+        return m_Ready;
+    }
+
+    void Model::Submit(RenderQueue &queue, const DrawItem &item, RenderPass pass, float depth, const Frustum *frustum) const {
+        if (!m_Ready) {
+            return;
+        }
+        for (const Mesh &mesh: meshes) {
+            if (frustum && !frustum->intersects(mesh.bounds, item.model)) {
+                continue;
+            }
+            mesh.Submit(queue, item, pass, depth);
+        }
+    }
+
+    AABB Model::getBounds() const {
+        AABB bounds;
+        for (unsigned int i = 0; i < meshes.size(); ++i) {
+            if (i == 0) {
+                bounds = meshes[i].bounds;
+            } else {
+                bounds.expand(meshes[i].bounds);
+            }
+        }
+        return bounds;
+    }
+
+    VertexFormat Model::getVertexFormat() const {
+        return m_VertexFormat;
+    }
+
+    std::size_t Model::getVertexBufferSize() const {
+        std::size_t size = 0;
+        for (const Mesh &mesh: meshes) {
+            size += mesh.getVertexBufferSize();
+        }
+        return size;
+    }
+
+    std::size_t Model::getIndexBufferSize() const {
+        std::size_t size = 0;
+        for (const Mesh &mesh: meshes) {
+            size += mesh.getIndexBufferSize();
+        }
+        return size;
+    }
+
+    std::size_t Model::getResidentSize() const {
+        std::size_t size = 0;
+        for (const Mesh &mesh: meshes) {
+            size += mesh.getResidentSize();
+        }
+        return size;
     }
 
     void Model::Draw(Shader &shader) {
+        if (!m_Ready) {
+            return;
+        }
         for (Mesh &mesh: meshes) {
             mesh.Draw(shader);
         }
     }
 
-    void Model::loadModel(std::string path) {
+    void Model::loadModel(std::string path, bool useCache) {
+        this->directory = path.substr(0, path.find_last_of('/'));
+
+        std::uint64_t sourceHash = 0;
+        if (useCache) {
+            sourceHash = MeshCache::hashSource(path);
+            MeshCache cache;
+            if (cache.open(MeshCache::pathFor(path), sourceHash)) {
+                // warm start, geometry goes from the mapped file straight to the GPU
+                loadTextures(cache.getTextures());
+                for (unsigned int i = 0; i < cache.getMeshCount(); ++i) {
+                    MeshCache::MeshView mesh = cache.getMesh(i);
+                    addMesh(mesh.vertices, mesh.vertexCount, mesh.indices, mesh.indexCount, mesh.textures, mesh.textureCount, mesh.bounds,
+                            mesh.packedVertices);
+                }
+                return;
+            }
+        }
+
+        ModelData data;
+        importModel(path, data);
+        if (useCache && !MeshCache::write(MeshCache::pathFor(path), sourceHash, data)) {
+            std::cerr << "Failed to write mesh cache for " << path << '\n';
+        }
+
+        loadTextures(data.textures);
+        for (MeshData &mesh: data.meshes) {
+            addMesh(std::move(mesh));
+        }
+    }
+
+    void Model::importModel(std::string path, ModelData &data) {
         Assimp::Importer importer;
         const aiScene *scene = importer.ReadFile(path, aiProcess_Triangulate |
                                                        aiProcess_GenSmoothNormals | aiProcess_FlipUVs |
@@ -27,26 +128,48 @@ namespace rg {
             ASSERT(false, "Failed to load a model!");
             return;
         }
-        this->directory = path.substr(0, path.find_last_of('/'));
-        processNode(scene->mRootNode, scene);
+        processNode(scene->mRootNode, scene, data);
+
+        // done once here, the mesh cache keeps the optimised order
+        VertexCacheStats before, after, total[2];
+        for (MeshData &mesh: data.meshes) {
+            optimizeMesh(mesh, true, &before, &after);
+            total[0].triangles += before.triangles;
+            total[0].vertices += before.vertices;
+            total[0].transforms += before.transforms;
+            total[1].triangles += after.triangles;
+            total[1].vertices += after.vertices;
+            total[1].transforms += after.transforms;
+        }
+        for (VertexCacheStats &stats: total) {
+            if (stats.triangles > 0 && stats.vertices > 0) {
+                stats.acmr = (float) stats.transforms / stats.triangles;
+                stats.atvr = (float) stats.transforms / stats.vertices;
+            }
+        }
+        std::printf("%s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", path.c_str(),
+                    total[0].acmr, total[1].acmr, total[0].atvr, total[1].atvr);
     }
 
-    void Model::processNode(aiNode *node, const aiScene *scene) {
+    void Model::processNode(aiNode *node, const aiScene *scene, ModelData &data) {
         for (unsigned int i = 0; i < node->mNumMeshes; ++i) {
             aiMesh *mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes.push_back(processMesh(mesh, scene));
+            data.meshes.push_back(processMesh(mesh, scene, data));
         }
 
         for (unsigned int i = 0; i < node->mNumChildren; ++i) {
-            processNode(node->mChildren[i], scene);
+            processNode(node->mChildren[i], scene, data);
         }
     }
 
-    Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene) {
-        std::vector<Vertex> vertices;
-        std::vector<unsigned int> indices;
-        std::vector<Texture> textures;
-
+    MeshData Model::processMesh(aiMesh *mesh, const aiScene *scene, ModelData &data) {
+        MeshData result;
+        std::vector<Vertex> &vertices = result.vertices;
+        std::vector<unsigned int> &indices = result.indices;
+        std::vector<unsigned int> &textures = result.textures;
+        vertices.reserve(mesh->mNumVertices);
+        // triangulated, anything else only costs a reallocation
+        indices.reserve(3 * mesh->mNumFaces);
         for (unsigned int i = 0; i < mesh->mNumVertices; ++i) {
             Vertex vertex;
             vertex.Position.x = mesh->mVertices[i].x;
@@ -76,6 +199,14 @@ namespace rg {
             vertices.push_back(vertex);
         }
 
+        if (!vertices.empty()) {
+            result.bounds.min = result.bounds.max = vertices[0].Position;
+            for (const Vertex &vertex: vertices) {
+                result.bounds.min = glm::min(result.bounds.min, vertex.Position);
+                result.bounds.max = glm::max(result.bounds.max, vertex.Position);
+            }
+        }
+
         for (unsigned int i = 0; i < mesh->mNumFaces; ++i) {
             aiFace face = mesh->mFaces[i];
 
@@ -86,21 +217,21 @@ namespace rg {
 
         aiMaterial *material = scene->mMaterials[mesh->mMaterialIndex];
 
-        loadTextureMaterial(material, aiTextureType_DIFFUSE, "texture_diffuse", textures);
+        loadTextureMaterial(material, aiTextureType_DIFFUSE, "texture_diffuse", data, textures);
 
         loadTextureMaterial(material, aiTextureType_SPECULAR, "texture_specular",
-                            textures);
+                            data, textures);
 
-        loadTextureMaterial(material, aiTextureType_NORMALS, "texture_normal", textures);
+        loadTextureMaterial(material, aiTextureType_NORMALS, "texture_normal", data, textures);
 
-        loadTextureMaterial(material, aiTextureType_HEIGHT, "texture_height", textures);
+        loadTextureMaterial(material, aiTextureType_HEIGHT, "texture_height", data, textures);
 
 
-        return Mesh(vertices, indices, textures);
+        return result;
     }
 
     void Model::loadTextureMaterial(aiMaterial *mat, aiTextureType type, std::string typeName,
-                                    std::vector<Texture> &textures) {
+                                    ModelData &data, std::vector<unsigned int> &textures) {
 
         for (unsigned int i = 0; i < mat->GetTextureCount(type); ++i) {
             aiString str;
@@ -108,9 +239,9 @@ namespace rg {
 
             bool skip = false;
 
-            for (unsigned int j = 0; j < loaded_textures.size(); ++j) {
-                if (std::strcmp(str.C_Str(), loaded_textures[j].path.c_str()) == 0) {
-                    textures.push_back(loaded_textures[j]);
+            for (unsigned int j = 0; j < data.textures.size(); ++j) {
+                if (std::strcmp(str.C_Str(), data.textures[j].path.c_str()) == 0) {
+                    textures.push_back(j);
                     skip = true;
                     break;
                 }
@@ -118,45 +249,61 @@ namespace rg {
 
             if (!skip) {
                 Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
+                texture.id = 0;
                 texture.type = typeName;
                 texture.path = str.C_Str();
-                textures.push_back(texture);
-                loaded_textures.push_back(texture);
+                textures.push_back(data.textures.size());
+                data.textures.push_back(texture);
             }
         }
     }
 
+    void Model::loadTextures(const std::vector<Texture> &textures) {
+        for (const Texture &texture: textures) {
+            Texture loaded = texture;
+            if (m_TextureLoader) {
+                loaded.id = m_TextureLoader->request(this->directory + "/" + texture.path);
+            } else {
+                loaded.id = TextureFromFile(texture.path.c_str(), this->directory);
+            }
+            loaded_textures.push_back(loaded);
+        }
+    }
+
+    void Model::addMesh(const Vertex *vertices, std::size_t vertexCount, const unsigned int *indices, std::size_t indexCount,
+                        const unsigned int *textureIndices, std::size_t textureCount, const AABB &bounds,
+                        const PackedVertex *packedVertices) {
+        std::vector<Texture> textures;
+        for (std::size_t i = 0; i < textureCount; ++i) {
+            textures.push_back(loaded_textures[textureIndices[i]]);
+        }
+        meshes.emplace_back(vertices, vertexCount, indices, indexCount, textures, m_VertexFormat, m_KeepGeometry,
+                            packedVertices, bounds);
+        meshes.back().bounds = bounds;
+    }
+
+    void Model::addMesh(MeshData &&mesh) {
+        std::vector<Texture> textures;
+        for (unsigned int textureIndex: mesh.textures) {
+            textures.push_back(loaded_textures[textureIndex]);
+        }
+        meshes.emplace_back(std::move(mesh.vertices), std::move(mesh.indices), textures, m_VertexFormat, m_KeepGeometry);
+        meshes.back().bounds = mesh.bounds;
+    }
+
     unsigned int TextureFromFile(const char *filename, std::string directory) {
         std::string fullPath(directory + "/" + filename);
 
         unsigned int textureID;
         glGenTextures(1, &textureID);
 
-        int width, height, nrComponents;
-        unsigned char *data = stbi_load(fullPath.c_str(), &width, &height, &nrComponents, 0);
-        if (data) {
-            GLenum format = GL_RED;
-            if (nrComponents == 1) {
-                format = GL_RED;
-            } else if (nrComponents == 3) {
-                format = GL_RGB;
-            } else if (nrComponents == 4) {
-                format = GL_RGBA;
-            }
-
-            glBindTexture(GL_TEXTURE_2D, textureID);
-            glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-            glGenerateMipmap(GL_TEXTURE_2D);
-
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        Image image = decodeImage(fullPath);
+        if (image.data) {
+            uploadImage(textureID, image, false);
         } else {
             ASSERT(false, "Failed to load texture image");
         }
-        stbi_image_free(data);
+        freeImage(image);
         return textureID;
     }
 
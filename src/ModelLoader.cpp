@@ -0,0 +1,114 @@
+#include "rg/ModelLoader.h"
+#include <iostream>
+#include <utility>
+
+namespace rg {
+
+    ModelHandle::ModelHandle(std::shared_ptr<Model> model)
+            : m_Model(std::move(model)) {
+    }
+
+    bool ModelHandle::isReady() const {
+        return m_Model && m_Model->isReady();
+    }
+
+    Model &ModelHandle::operator*() const {
+        return *m_Model;
+    }
+
+    Model *ModelHandle::operator->() const {
+        return m_Model.get();
+    }
+
+    ModelLoader::ModelLoader(ThreadPool &pool, TextureLoader &textureLoader)
+            : m_Pool(pool), m_TextureLoader(textureLoader) {
+    }
+
+    ModelHandle ModelLoader::request(const std::string &path, VertexFormat vertexFormat, bool keepGeometry) {
+        std::shared_ptr<Job> job = std::make_shared<Job>();
+        job->model = std::shared_ptr<Model>(new Model());
+        job->model->m_TextureLoader = &m_TextureLoader;
+        job->model->m_VertexFormat = vertexFormat;
+        job->model->m_KeepGeometry = keepGeometry;
+        job->model->directory = path.substr(0, path.find_last_of('/'));
+        job->path = path;
+        m_Jobs.push_back(job);
+
+        m_Pool.submit([job] {
+            parse(*job);
+            job->parsed.store(true, std::memory_order_release);
+        });
+        return ModelHandle(job->model);
+    }
+
+    void ModelLoader::parse(Job &job) {
+        std::uint64_t sourceHash = MeshCache::hashSource(job.path);
+        std::unique_ptr<MeshCache> cache(new MeshCache());
+        if (cache->open(MeshCache::pathFor(job.path), sourceHash)) {
+            job.cache = std::move(cache);
+            return;
+        }
+
+        job.model->importModel(job.path, job.data);
+        if (!MeshCache::write(MeshCache::pathFor(job.path), sourceHash, job.data)) {
+            std::cerr << "Failed to write mesh cache for " << job.path << '\n';
+        }
+    }
+
+    void ModelLoader::update(double budgetMs) {
+        auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                std::chrono::duration<double, std::milli>(budgetMs));
+
+        m_TextureLoader.update(deadline);
+
+        bool uploadedAny = false;
+        for (auto it = m_Jobs.begin(); it != m_Jobs.end();) {
+            Job &job = **it;
+            if (!job.parsed.load(std::memory_order_acquire)) {
+                ++it;
+                continue;
+            }
+            if (upload(job, deadline, uploadedAny)) {
+                job.model->m_Ready = true;
+                it = m_Jobs.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    bool ModelLoader::upload(Job &job, std::chrono::steady_clock::time_point deadline, bool &uploadedAny) {
+        Model &model = *job.model;
+
+        if (!job.texturesRequested) {
+            // decoding runs on the pool, TextureLoader::update() uploads in later frames
+            model.loadTextures(job.cache ? job.cache->getTextures() : job.data.textures);
+            job.lastTextureRequest = m_TextureLoader.getRequestCount();
+            job.texturesRequested = true;
+        }
+
+        unsigned int meshCount = job.cache ? job.cache->getMeshCount() : job.data.meshes.size();
+        while (job.nextMesh < meshCount) {
+            if (uploadedAny && std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+            if (job.cache) {
+                MeshCache::MeshView mesh = job.cache->getMesh(job.nextMesh);
+                model.addMesh(mesh.vertices, mesh.vertexCount, mesh.indices, mesh.indexCount, mesh.textures, mesh.textureCount, mesh.bounds,
+                              mesh.packedVertices);
+            } else {
+                model.addMesh(std::move(job.data.meshes[job.nextMesh]));
+            }
+            ++job.nextMesh;
+            uploadedAny = true;
+        }
+
+        return m_TextureLoader.getUploadCount() >= job.lastTextureRequest;
+    }
+
+    unsigned int ModelLoader::getPendingCount() const {
+        return m_Jobs.size();
+    }
+
+}
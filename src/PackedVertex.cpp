@@ -0,0 +1,104 @@
+#include "rg/PackedVertex.h"
+#include "rg/Mesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace rg {
+
+    static std::int16_t snorm16(float value) {
+        return (std::int16_t) std::lround(std::max(-1.0f, std::min(1.0f, value)) * 32767.0f);
+    }
+
+    static std::uint16_t unorm16(float value) {
+        return (std::uint16_t) std::lround(std::max(0.0f, std::min(1.0f, value)) * 65535.0f);
+    }
+
+    float packedPositionScale(const AABB &bounds) {
+        glm::vec3 size = bounds.max - bounds.min;
+        float scale = std::max(size.x, std::max(size.y, size.z));
+        return scale > 0.0f ? scale : 1.0f;
+    }
+
+    glm::mat4 packedPositionDecode(const AABB &bounds) {
+        float scale = packedPositionScale(bounds);
+        glm::mat4 decode(1.0f);
+        decode[0][0] = scale;
+        decode[1][1] = scale;
+        decode[2][2] = scale;
+        decode[3] = glm::vec4(bounds.min, 1.0f);
+        return decode;
+    }
+
+    PackedVertex packVertex(const Vertex &vertex, const AABB &bounds) {
+        PackedVertex packed;
+        float scale = packedPositionScale(bounds);
+        glm::vec3 position = (vertex.Position - bounds.min) / scale;
+        packed.Position[0] = unorm16(position.x);
+        packed.Position[1] = unorm16(position.y);
+        packed.Position[2] = unorm16(position.z);
+        bool flipped = glm::dot(glm::cross(vertex.Normal, vertex.Tangent), vertex.Bitangent) < 0.0f;
+        packed.Position[3] = flipped ? 0 : 65535;
+
+        glm::vec2 normal = octEncode(vertex.Normal);
+        packed.Normal[0] = snorm16(normal.x);
+        packed.Normal[1] = snorm16(normal.y);
+        glm::vec2 tangent = octEncode(vertex.Tangent);
+        packed.Tangent[0] = snorm16(tangent.x);
+        packed.Tangent[1] = snorm16(tangent.y);
+
+        packed.TexCoords[0] = floatToHalf(vertex.TexCoords.x);
+        packed.TexCoords[1] = floatToHalf(vertex.TexCoords.y);
+        return packed;
+    }
+
+    std::uint16_t floatToHalf(float value) {
+        std::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        std::uint32_t sign = (bits >> 16) & 0x8000u;
+        std::uint32_t mantissa = bits & 0x7fffffu;
+        if (((bits >> 23) & 0xffu) == 0xffu) {
+            // infinity stays infinity, NaN stays a NaN
+            return (std::uint16_t) (sign | 0x7c00u | (mantissa ? 0x200u : 0u));
+        }
+
+        int exponent = (int) ((bits >> 23) & 0xffu) - 127 + 15;
+        if (exponent >= 31) {
+            return (std::uint16_t) (sign | 0x7c00u);
+        }
+        if (exponent <= 0) {
+            if (exponent < -10) {
+                return (std::uint16_t) sign;
+            }
+            mantissa |= 0x800000u;
+            unsigned int shift = 14 - exponent;
+            std::uint32_t half = mantissa >> shift;
+            if ((mantissa >> (shift - 1)) & 1u) {
+                ++half;
+            }
+            return (std::uint16_t) (sign | half);
+        }
+
+        std::uint32_t half = sign | ((std::uint32_t) exponent << 10) | (mantissa >> 13);
+        // a carry out of the mantissa correctly bumps the exponent
+        if (mantissa & 0x1000u) {
+            ++half;
+        }
+        return (std::uint16_t) half;
+    }
+
+    glm::vec2 octEncode(const glm::vec3 &n) {
+        float length = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+        if (length == 0.0f) {
+            return glm::vec2(0.0f);
+        }
+        glm::vec3 p = n / length;
+        if (p.z < 0.0f) {
+            return glm::vec2((1.0f - std::fabs(p.y)) * (p.x >= 0.0f ? 1.0f : -1.0f),
+                             (1.0f - std::fabs(p.x)) * (p.y >= 0.0f ? 1.0f : -1.0f));
+        }
+        return glm::vec2(p.x, p.y);
+    }
+
+}
@@ -0,0 +1,281 @@
+#include "rg/Profiler.h"
+#include "imgui.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace rg {
+
+    const unsigned int Profiler::FRAMES;
+
+    Profiler::Profiler(unsigned int traceFrames)
+            : m_Epoch(std::chrono::steady_clock::now()), m_TraceCapacity(traceFrames) {
+    }
+
+    double Profiler::now() const {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_Epoch).count();
+    }
+
+    void Profiler::beginFrame() {
+        m_Current = (m_Current + 1) % FRAMES;
+        Frame &frame = m_Frames[m_Current];
+        if (frame.recorded) {
+            resolve(frame);
+        }
+        frame.samples.clear();
+        frame.usedQueries = 0;
+        frame.start = now();
+        frame.recorded = true;
+    }
+
+    void Profiler::endFrame() {
+        while (!m_Stack.empty()) {
+            end();
+        }
+    }
+
+    void Profiler::begin(const char *name, bool gpu) {
+        Frame &frame = m_Frames[m_Current];
+
+        Sample sample;
+        sample.name = name;
+        sample.depth = m_Stack.size();
+        sample.start = now();
+        sample.cpuMs = 0.0;
+        sample.query = -1;
+        sample.gpuMs = -1.0;
+
+        if (gpu && m_OpenQuery == -1) {
+            if (frame.usedQueries == frame.queries.size()) {
+                unsigned int query;
+                glGenQueries(1, &query);
+                frame.queries.push_back(query);
+            }
+            sample.query = frame.usedQueries++;
+            m_OpenQuery = sample.query;
+            glBeginQuery(GL_TIME_ELAPSED, frame.queries[sample.query]);
+        }
+
+        m_Stack.push_back(frame.samples.size());
+        frame.samples.push_back(sample);
+    }
+
+    void Profiler::end() {
+        if (m_Stack.empty()) {
+            return;
+        }
+        Frame &frame = m_Frames[m_Current];
+        Sample &sample = frame.samples[m_Stack.back()];
+        m_Stack.pop_back();
+
+        sample.cpuMs = now() - sample.start;
+        if (sample.query != -1) {
+            glEndQuery(GL_TIME_ELAPSED);
+            m_OpenQuery = -1;
+        }
+    }
+
+    Profiler::Track &Profiler::track(const char *name) {
+        for (Track &track: m_Tracks) {
+            if (std::strcmp(track.name, name) == 0) {
+                return track;
+            }
+        }
+        m_Tracks.emplace_back();
+        m_Tracks.back().name = name;
+        return m_Tracks.back();
+    }
+
+    void Profiler::resolve(Frame &frame) {
+        // names with a query that hasn't finished yet
+        std::vector<const char *> pending;
+        for (Sample &sample: frame.samples) {
+            if (sample.query != -1) {
+                GLuint available = GL_FALSE;
+                glGetQueryObjectuiv(frame.queries[sample.query], GL_QUERY_RESULT_AVAILABLE, &available);
+                if (available) {
+                    GLuint64 elapsed = 0;
+                    glGetQueryObjectui64v(frame.queries[sample.query], GL_QUERY_RESULT, &elapsed);
+                    sample.gpuMs = elapsed / 1000000.0;
+                } else {
+                    pending.push_back(sample.name);
+                }
+            }
+        }
+
+        std::vector<Timing> previous;
+        previous.swap(m_Timings);
+        for (const Sample &sample: frame.samples) {
+            auto timing = std::find_if(m_Timings.begin(), m_Timings.end(), [&sample](const Timing &timing) {
+                return std::strcmp(timing.name, sample.name) == 0;
+            });
+            if (timing == m_Timings.end()) {
+                m_Timings.push_back(Timing{sample.name, sample.depth, 0.0, -1.0});
+                timing = m_Timings.end() - 1;
+            }
+            timing->cpuMs += sample.cpuMs;
+            if (sample.gpuMs >= 0.0) {
+                timing->gpuMs = std::max(timing->gpuMs, 0.0) + sample.gpuMs;
+            }
+        }
+        for (const char *name: pending) {
+            auto sameName = [name](const Timing &timing) {
+                return std::strcmp(timing.name, name) == 0;
+            };
+            auto timing = std::find_if(m_Timings.begin(), m_Timings.end(), sameName);
+            auto last = std::find_if(previous.begin(), previous.end(), sameName);
+            timing->gpuMs = last != previous.end() ? last->gpuMs : -1.0;
+        }
+
+        // scopes missing from this frame count as zero so every track stays aligned
+        for (Track &track: m_Tracks) {
+            track.cpuMs.push_back(0.0f);
+            track.gpuMs.push_back(0.0f);
+        }
+        std::size_t length = m_Tracks.empty() ? 1 : m_Tracks.front().cpuMs.size();
+        for (const Timing &timing: m_Timings) {
+            Track &current = track(timing.name);
+            if (current.cpuMs.empty()) {
+                current.cpuMs.assign(length, 0.0f);
+                current.gpuMs.assign(length, 0.0f);
+            }
+            current.cpuMs.back() = timing.cpuMs;
+            current.gpuMs.back() = timing.gpuMs > 0.0 ? timing.gpuMs : 0.0f;
+        }
+        for (Track &track: m_Tracks) {
+            while (track.cpuMs.size() > HISTORY) {
+                track.cpuMs.pop_front();
+                track.gpuMs.pop_front();
+            }
+        }
+
+        if (m_TraceCapacity > 0) {
+            m_TraceFrames.push_back(frame.samples);
+            if (m_TraceFrames.size() > m_TraceCapacity) {
+                m_TraceFrames.pop_front();
+            }
+        }
+    }
+
+    const std::vector<Profiler::Timing> &Profiler::getTimings() const {
+        return m_Timings;
+    }
+
+    const std::vector<Profiler::Track> &Profiler::getTracks() const {
+        return m_Tracks;
+    }
+
+    bool Profiler::writeChromeTrace(const std::string &path) const {
+        std::ofstream out(path);
+        if (!out) {
+            return false;
+        }
+
+        out << "{\"traceEvents\":[\n";
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"CPU\"}},\n";
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":1,\"args\":{\"name\":\"GPU\"}}";
+        for (const std::vector<Sample> &samples: m_TraceFrames) {
+            for (const Sample &sample: samples) {
+                // microseconds
+                out << ",\n{\"name\":\"" << sample.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":"
+                    << sample.start * 1000.0 << ",\"dur\":" << sample.cpuMs * 1000.0 << "}";
+                if (sample.gpuMs >= 0.0) {
+                    out << ",\n{\"name\":\"" << sample.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":1,\"ts\":"
+                        << sample.start * 1000.0 << ",\"dur\":" << sample.gpuMs * 1000.0 << "}";
+                }
+            }
+        }
+        out << "\n]}\n";
+        return (bool) out;
+    }
+
+    void Profiler::drawOverlay() {
+        ImGui::Begin("Profiler");
+
+        if (ImGui::BeginTable("timings", 3, ImGuiTableFlags_RowBg)) {
+            ImGui::TableSetupColumn("scope");
+            ImGui::TableSetupColumn("CPU ms");
+            ImGui::TableSetupColumn("GPU ms");
+            ImGui::TableHeadersRow();
+            for (const Timing &timing: m_Timings) {
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0);
+                ImGui::Text("%*s%s", (int) timing.depth * 2, "", timing.name);
+                ImGui::TableSetColumnIndex(1);
+                ImGui::Text("%.3f", timing.cpuMs);
+                ImGui::TableSetColumnIndex(2);
+                if (timing.gpuMs >= 0.0) {
+                    ImGui::Text("%.3f", timing.gpuMs);
+                } else {
+                    ImGui::TextUnformatted("-");
+                }
+            }
+            ImGui::EndTable();
+        }
+
+        // rolling stacked bars, one column per frame, one colour per GPU timed scope
+        std::size_t frames = m_Tracks.empty() ? 0 : m_Tracks.front().gpuMs.size();
+        float highest = 1.0f;
+        for (std::size_t i = 0; i < frames; ++i) {
+            float total = 0.0f;
+            for (const Track &track: m_Tracks) {
+                total += track.gpuMs[i];
+            }
+            highest = std::max(highest, total);
+        }
+
+        ImVec2 size(ImGui::GetContentRegionAvail().x, 120.0f);
+        ImVec2 origin = ImGui::GetCursorScreenPos();
+        ImDrawList *drawList = ImGui::GetWindowDrawList();
+        drawList->AddRectFilled(origin, ImVec2(origin.x + size.x, origin.y + size.y), IM_COL32(20, 20, 20, 255));
+        float barWidth = size.x / HISTORY;
+        for (std::size_t i = 0; i < frames; ++i) {
+            float x = origin.x + (HISTORY - frames + i) * barWidth;
+            float y = origin.y + size.y;
+            for (std::size_t t = 0; t < m_Tracks.size(); ++t) {
+                float height = m_Tracks[t].gpuMs[i] / highest * size.y;
+                if (height <= 0.0f) {
+                    continue;
+                }
+                ImU32 colour = ImColor::HSV(t * 0.13f, 0.6f, 0.9f);
+                drawList->AddRectFilled(ImVec2(x, y - height), ImVec2(x + barWidth, y), colour);
+                y -= height;
+            }
+        }
+        ImGui::Dummy(size);
+        ImGui::Text("GPU ms, top of chart = %.2f", highest);
+
+        for (std::size_t t = 0; t < m_Tracks.size(); ++t) {
+            if (t % 4 != 0) {
+                ImGui::SameLine();
+            }
+            ImGui::ColorButton(m_Tracks[t].name, ImColor::HSV(t * 0.13f, 0.6f, 0.9f), ImGuiColorEditFlags_NoTooltip, ImVec2(10, 10));
+            ImGui::SameLine();
+            ImGui::TextUnformatted(m_Tracks[t].name);
+        }
+
+        if (ImGui::Button("Export Chrome trace")) {
+            const char *path = "profile_trace.json";
+            if (writeChromeTrace(path)) {
+                std::cout << "Profiler trace written to " << path << '\n';
+            } else {
+                std::cerr << "Failed to write " << path << '\n';
+            }
+        }
+
+        ImGui::End();
+    }
+
+    void Profiler::free() {
+        for (Frame &frame: m_Frames) {
+            if (!frame.queries.empty()) {
+                glDeleteQueries(frame.queries.size(), frame.queries.data());
+            }
+            frame.queries.clear();
+            frame.recorded = false;
+        }
+    }
+
+}
@@ -0,0 +1,222 @@
+#include "rg/RenderQueue.h"
+#include "rg/GLState.h"
+#include "rg/GLExtensions.h"
+#include "rg/Mesh.h"
+#include "rg/Profiler.h"
+
+#include <cstring>
+
+namespace rg {
+
+    static const unsigned int DEPTH_BITS = 20;
+    static const unsigned int VAO_BITS = 16;
+    static const unsigned int MATERIAL_BITS = 14;
+    static const unsigned int PROGRAM_BITS = 10;
+
+    static std::uint64_t quantizeDepth(float depth) {
+        if (!(depth > 0.0f)) {
+            depth = 0.0f;
+        } else if (depth > 1.0f) {
+            depth = 1.0f;
+        }
+        return (std::uint64_t) (depth * ((1u << DEPTH_BITS) - 1));
+    }
+
+    // FNV-1a over the bound textures, equal sets end up next to each other
+    static std::uint64_t materialBits(const DrawItem &item) {
+        std::uint32_t hash = 2166136261u;
+        for (unsigned int i = 0; i < item.textureCount; ++i) {
+            hash ^= item.textures[i];
+            hash *= 16777619u;
+        }
+        return (hash ^ (hash >> MATERIAL_BITS)) & ((1u << MATERIAL_BITS) - 1);
+    }
+
+    std::uint64_t RenderQueue::makeKey(const DrawItem &item, RenderPass pass, float depth) {
+        std::uint64_t program = item.program & ((1u << PROGRAM_BITS) - 1);
+        std::uint64_t material = materialBits(item);
+        std::uint64_t vao = item.vao & ((1u << VAO_BITS) - 1);
+        std::uint64_t key = (std::uint64_t) pass << 60;
+
+        if (pass == PASS_TRANSPARENT) {
+            // back to front first, state only breaks ties
+            std::uint64_t farFirst = ((1u << DEPTH_BITS) - 1) - quantizeDepth(depth);
+            key |= farFirst << 40;
+            key |= program << 30;
+            key |= material << 16;
+            key |= vao;
+        } else {
+            // state first, front to back within equal state
+            key |= program << 50;
+            key |= material << 36;
+            key |= vao << 20;
+            key |= quantizeDepth(depth);
+        }
+        return key;
+    }
+
+    void RenderQueue::submit(const DrawItem &item, RenderPass pass, float depth) {
+        SortEntry entry;
+        entry.key = makeKey(item, pass, depth);
+        entry.index = m_Items.size();
+        m_Items.push_back(item);
+        m_Order.push_back(entry);
+        m_Sorted = false;
+    }
+
+    void RenderQueue::sort() {
+        if (m_Sorted) {
+            return;
+        }
+        m_Sorted = true;
+        m_Stats = Stats();
+        if (m_Order.empty()) {
+            return;
+        }
+
+        // LSD radix sort, 8 bits per pass, passes where every key has the same byte are skipped
+        std::size_t count = m_Order.size();
+        m_Scratch.resize(count);
+        for (unsigned int shift = 0; shift < 64; shift += 8) {
+            std::size_t histogram[256] = {};
+            for (const SortEntry &entry: m_Order) {
+                ++histogram[(entry.key >> shift) & 0xff];
+            }
+            if (histogram[(m_Order[0].key >> shift) & 0xff] == count) {
+                continue;
+            }
+
+            std::size_t offset = 0;
+            for (std::size_t &bucket: histogram) {
+                std::size_t size = bucket;
+                bucket = offset;
+                offset += size;
+            }
+            for (const SortEntry &entry: m_Order) {
+                m_Scratch[histogram[(entry.key >> shift) & 0xff]++] = entry;
+            }
+            m_Order.swap(m_Scratch);
+        }
+    }
+
+    void RenderQueue::count(bool forwarded) {
+        if (forwarded) {
+            ++m_Stats.binds;
+        } else {
+            ++m_Stats.skippedBinds;
+        }
+    }
+
+    void RenderQueue::execute(Profiler *profiler) {
+        sort();
+        draw(0, m_Order.size(), profiler);
+    }
+
+    void RenderQueue::execute(RenderPass pass, Profiler *profiler) {
+        sort();
+        // the pass is in the top bits of the key, its items are one run of the sorted order
+        std::size_t begin = 0;
+        while (begin < m_Order.size() && (m_Order[begin].key >> 60) < (std::uint64_t) pass) {
+            ++begin;
+        }
+        std::size_t end = begin;
+        while (end < m_Order.size() && (m_Order[end].key >> 60) == (std::uint64_t) pass) {
+            ++end;
+        }
+        draw(begin, end, profiler);
+    }
+
+    void RenderQueue::draw(std::size_t begin, std::size_t end, Profiler *profiler) {
+        const char *scope = nullptr;
+        for (std::size_t i = begin; i < end; ++i) {
+            const DrawItem &item = m_Items[m_Order[i].index];
+
+            if (profiler && item.scope != scope && (!item.scope || !scope || std::strcmp(item.scope, scope) != 0)) {
+                if (scope) {
+                    profiler->end();
+                }
+                if (item.scope) {
+                    profiler->begin(item.scope);
+                }
+                scope = item.scope;
+            }
+
+            count(GLState::useProgram(item.program));
+            count(GLState::cullFace(item.cullFace));
+            count(GLState::frontFace(item.frontFace));
+            for (unsigned int unit = 0; unit < item.textureCount; ++unit) {
+                count(GLState::bindTexture(unit, item.textures[unit]));
+            }
+            count(GLState::bindVertexArray(item.vao));
+
+            if (item.modelUniform.isActive()) {
+                item.modelUniform.set(item.model);
+            }
+
+            if (item.drawCount > 0) {
+                multiDraw(item);
+            } else if (item.indexed) {
+                if (item.instanceCount == 1) {
+                    glDrawElements(item.mode, item.count, item.indexType, 0);
+                } else {
+                    glDrawElementsInstanced(item.mode, item.count, item.indexType, 0, item.instanceCount);
+                }
+            } else {
+                if (item.instanceCount == 1) {
+                    glDrawArrays(item.mode, 0, item.count);
+                } else {
+                    glDrawArraysInstanced(item.mode, 0, item.count, item.instanceCount);
+                }
+            }
+            ++m_Stats.draws;
+        }
+
+        if (profiler && scope) {
+            profiler->end();
+        }
+    }
+
+    void RenderQueue::multiDraw(const DrawItem &item) {
+        if (item.indirectBuffer) {
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, item.indirectBuffer);
+            void *offset = (void *) (item.firstCommand * sizeof(DrawElementsIndirectCommand));
+            if (item.drawCount == 1) {
+                GLExtensions::drawElementsIndirect(item.mode, item.indexType, offset);
+            } else {
+                GLExtensions::multiDrawElementsIndirect(item.mode, item.indexType, offset, item.drawCount, 0);
+            }
+            return;
+        }
+        // GL 3.3, the draw index is a constant attribute instead of an instanced one
+        std::size_t indexSize = indexTypeSize(item.indexType);
+        for (GLsizei i = item.firstCommand; i < item.firstCommand + item.drawCount; ++i) {
+            const DrawElementsIndirectCommand &command = item.commands[i];
+            if (command.instanceCount == 0) {
+                continue;
+            }
+            glVertexAttribI1ui(DRAW_INDEX_LOCATION, command.baseInstance);
+            void *indices = (void *) (command.firstIndex * indexSize);
+            if (command.instanceCount == 1) {
+                glDrawElementsBaseVertex(item.mode, command.count, item.indexType, indices, command.baseVertex);
+            } else {
+                glDrawElementsInstancedBaseVertex(item.mode, command.count, item.indexType, indices, command.instanceCount,
+                                                  command.baseVertex);
+            }
+        }
+    }
+
+    void RenderQueue::clear() {
+        m_Items.clear();
+        m_Order.clear();
+        m_Sorted = false;
+    }
+
+    const RenderQueue::Stats &RenderQueue::getStats() const {
+        return m_Stats;
+    }
+
+    unsigned int RenderQueue::size() const {
+        return m_Items.size();
+    }
+
+}
@@ -4,6 +4,8 @@
 
 #include "rg/Shader.h"
 #include "rg/Error.h"
+#include "rg/GLState.h"
+#include "rg/GLExtensions.h"
 #include "common.h"
 
 namespace rg {
@@ -56,64 +58,217 @@ namespace rg {
             glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
             std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
         }
+        m_Linked = success != 0;
 
         glDeleteShader(vertexShader);
         glDeleteShader(fragmentShader);
         m_Id = shaderProgram;
+
+        reflectUniforms();
+    }
+
+    Shader::Shader(std::string computeShaderPath) {
+        std::string csString = readFileContents(computeShaderPath);
+        ASSERT(!csString.empty(), "Compute shader source is empty!");
+        const char *computeShaderSource = csString.c_str();
+
+        unsigned int computeShader = glCreateShader(GL_COMPUTE_SHADER);
+        glShaderSource(computeShader, 1, &computeShaderSource, NULL);
+        glCompileShader(computeShader);
+        int success;
+        char infoLog[512];
+        glGetShaderiv(computeShader, GL_COMPILE_STATUS, &success);
+        if (!success) {
+            glGetShaderInfoLog(computeShader, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::COMPUTE::COMPILATION_FAILED\n" << infoLog << std::endl;
+        }
+
+        unsigned int shaderProgram = glCreateProgram();
+        glAttachShader(shaderProgram, computeShader);
+        glLinkProgram(shaderProgram);
+        glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+        if (!success) {
+            glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        }
+        m_Linked = success != 0;
+
+        glDeleteShader(computeShader);
+        m_Id = shaderProgram;
+
+        reflectUniforms();
+    }
+
+    unsigned int Shader::s_Lookups = 0;
+    unsigned int Shader::s_LookupsLastFrame = 0;
+
+    static std::uint32_t hashUniformName(const char *name) {
+        // FNV-1a
+        std::uint32_t hash = 2166136261u;
+        for (; *name; ++name) {
+            hash ^= (unsigned char) *name;
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    void Shader::reflectUniforms() {
+        int count = 0;
+        int maxLength = 0;
+        glGetProgramiv(m_Id, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(m_Id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+        std::vector<std::pair<std::string, int>> active;
+        std::vector<char> buffer(maxLength + 1);
+        for (int i = 0; i < count; ++i) {
+            int size = 0;
+            GLenum type;
+            glGetActiveUniform(m_Id, i, (GLsizei) buffer.size(), NULL, &size, &type, buffer.data());
+            std::string name(buffer.data());
+            int location = glGetUniformLocation(m_Id, name.c_str());
+            // members of uniform blocks have no location
+            if (location == -1) {
+                continue;
+            }
+            active.emplace_back(name, location);
+
+            // arrays of basic types are reported once as "name[0]", register the bare name and every element
+            if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0) {
+                std::string base = name.substr(0, name.size() - 3);
+                active.emplace_back(base, location);
+                for (int j = 1; j < size; ++j) {
+                    std::string element = base + "[" + std::to_string(j) + "]";
+                    active.emplace_back(element, glGetUniformLocation(m_Id, element.c_str()));
+                }
+            }
+        }
+
+        // keep the table at most half full so probe chains stay short
+        unsigned int capacity = 16;
+        while (capacity < 2 * active.size()) {
+            capacity *= 2;
+        }
+        m_Uniforms.assign(capacity, UniformSlot());
+        for (auto &uniform: active) {
+            insertUniform(uniform.first, uniform.second);
+        }
+    }
+
+    void Shader::insertUniform(const std::string &name, int location) {
+        std::uint32_t hash = hashUniformName(name.c_str());
+        unsigned int mask = m_Uniforms.size() - 1;
+        for (unsigned int i = hash & mask;; i = (i + 1) & mask) {
+            UniformSlot &slot = m_Uniforms[i];
+            if (slot.name.empty()) {
+                slot.hash = hash;
+                slot.location = location;
+                slot.name = name;
+                return;
+            }
+            if (slot.hash == hash && slot.name == name) {
+                return;
+            }
+        }
+    }
+
+    int Shader::getUniformLocation(const std::string &name) const {
+        ++s_Lookups;
+        if (m_Uniforms.empty()) {
+            return -1;
+        }
+        std::uint32_t hash = hashUniformName(name.c_str());
+        unsigned int mask = m_Uniforms.size() - 1;
+        for (unsigned int i = hash & mask;; i = (i + 1) & mask) {
+            const UniformSlot &slot = m_Uniforms[i];
+            if (slot.name.empty()) {
+                return -1;
+            }
+            if (slot.hash == hash && slot.name == name) {
+                return slot.location;
+            }
+        }
+    }
+
+    unsigned int Shader::lookupsThisFrame() {
+        return s_Lookups;
+    }
+
+    unsigned int Shader::lookupsLastFrame() {
+        return s_LookupsLastFrame;
+    }
+
+    void Shader::endFrame() {
+        s_LookupsLastFrame = s_Lookups;
+        s_Lookups = 0;
+    }
+
+    void Shader::bindUniformBlock(const std::string &blockName, unsigned int binding) const {
+        unsigned int index = glGetUniformBlockIndex(m_Id, blockName.c_str());
+        if (index != GL_INVALID_INDEX) {
+            glUniformBlockBinding(m_Id, index, binding);
+        }
     }
 
     // activate the shader
     void Shader::use() {
-        glUseProgram(m_Id);
+        GLState::useProgram(m_Id);
+    }
+
+    unsigned int Shader::getId() const {
+        return m_Id;
+    }
+
+    bool Shader::isLinked() const {
+        return m_Linked;
     }
 
     // utility uniform functions
     void Shader::setBool(const std::string &name, bool value) const {
-        glUniform1i(glGetUniformLocation(m_Id, name.c_str()), (int) value);
+        glUniform1i(getUniformLocation(name), (int) value);
     }
 
     void Shader::setInt(const std::string &name, int value) const {
-        glUniform1i(glGetUniformLocation(m_Id, name.c_str()), value);
+        glUniform1i(getUniformLocation(name), value);
     }
 
     void Shader::setFloat(const std::string &name, float value) const {
-        glUniform1f(glGetUniformLocation(m_Id, name.c_str()), value);
+        glUniform1f(getUniformLocation(name), value);
     }
 
     void Shader::setVec2(const std::string &name, const glm::vec2 &value) const {
-        glUniform2fv(glGetUniformLocation(m_Id, name.c_str()), 1, &value[0]);
+        glUniform2fv(getUniformLocation(name), 1, &value[0]);
     }
 
     void Shader::setVec2(const std::string &name, float x, float y) const {
-        glUniform2f(glGetUniformLocation(m_Id, name.c_str()), x, y);
+        glUniform2f(getUniformLocation(name), x, y);
     }
 
     void Shader::setVec3(const std::string &name, const glm::vec3 &value) const {
-        glUniform3fv(glGetUniformLocation(m_Id, name.c_str()), 1, &value[0]);
+        glUniform3fv(getUniformLocation(name), 1, &value[0]);
     }
 
     void Shader::setVec3(const std::string &name, float x, float y, float z) const {
-        glUniform3f(glGetUniformLocation(m_Id, name.c_str()), x, y, z);
+        glUniform3f(getUniformLocation(name), x, y, z);
     }
 
     void Shader::setVec4(const std::string &name, const glm::vec4 &value) const {
-        glUniform4fv(glGetUniformLocation(m_Id, name.c_str()), 1, &value[0]);
+        glUniform4fv(getUniformLocation(name), 1, &value[0]);
     }
 
     void Shader::setVec4(const std::string &name, float x, float y, float z, float w) {
-        glUniform4f(glGetUniformLocation(m_Id, name.c_str()), x, y, z, w);
+        glUniform4f(getUniformLocation(name), x, y, z, w);
     }
 
     void Shader::setMat2(const std::string &name, const glm::mat2 &mat) const {
-        glUniformMatrix2fv(glGetUniformLocation(m_Id, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix2fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
     }
 
     void Shader::setMat3(const std::string &name, const glm::mat3 &mat) const {
-        glUniformMatrix3fv(glGetUniformLocation(m_Id, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix3fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
     }
 
     void Shader::setMat4(const std::string &name, const glm::mat4 &mat) const {
-        glUniformMatrix4fv(glGetUniformLocation(m_Id, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
     }
 
     Shader::~Shader() {
@@ -121,8 +276,9 @@ namespace rg {
     }
 
     void Shader::deleteProgram() {
-        glDeleteProgram(m_Id);
+        GLState::deleteProgram(m_Id);
         m_Id = 0;
+        m_Uniforms.clear();
     }
 
 }
\ No newline at end of file
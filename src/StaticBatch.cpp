@@ -0,0 +1,317 @@
+#include "rg/StaticBatch.h"
+#include "rg/GLExtensions.h"
+#include "rg/GLState.h"
+#include "rg/Error.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace rg {
+
+    const StaticBatch::ObjectId StaticBatch::INVALID_OBJECT;
+    const unsigned int StaticBatch::MATRIX_TEXTURE_UNIT;
+
+    // replaces buffer by one of capacity bytes that starts with its first used bytes
+    static void growBuffer(unsigned int &buffer, std::size_t used, std::size_t capacity) {
+        unsigned int grown;
+        glGenBuffers(1, &grown);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+        glBufferData(GL_COPY_WRITE_BUFFER, capacity, nullptr, GL_STATIC_DRAW);
+        if (buffer) {
+            if (used) {
+                glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+                glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, used);
+            }
+            glDeleteBuffers(1, &buffer);
+        }
+        buffer = grown;
+    }
+
+    template<typename T>
+    static std::vector<unsigned int> readIndices(std::size_t count) {
+        std::vector<T> narrow(count);
+        glGetBufferSubData(GL_COPY_READ_BUFFER, 0, count * sizeof(T), narrow.data());
+        return std::vector<unsigned int>(narrow.begin(), narrow.end());
+    }
+
+    // the first count indices of buffer, widened to unsigned int
+    static std::vector<unsigned int> readIndices(unsigned int buffer, GLenum indexType, std::size_t count) {
+        if (count == 0) {
+            return std::vector<unsigned int>();
+        }
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        if (indexType == GL_UNSIGNED_BYTE) {
+            return readIndices<GLubyte>(count);
+        }
+        if (indexType == GL_UNSIGNED_SHORT) {
+            return readIndices<GLushort>(count);
+        }
+        return readIndices<GLuint>(count);
+    }
+
+    template<typename T>
+    static void writeIndices(std::size_t first, const std::vector<unsigned int> &indices) {
+        std::vector<T> narrow(indices.begin(), indices.end());
+        glBufferSubData(GL_COPY_WRITE_BUFFER, first * sizeof(T), narrow.size() * sizeof(T), narrow.data());
+    }
+
+    // the caller made sure every index fits indexType
+    static void writeIndices(unsigned int buffer, GLenum indexType, std::size_t first, const std::vector<unsigned int> &indices) {
+        if (indices.empty()) {
+            return;
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        if (indexType == GL_UNSIGNED_SHORT) {
+            writeIndices<GLushort>(first, indices);
+        } else {
+            writeIndices<GLuint>(first, indices);
+        }
+    }
+
+    static bool lessTextures(const unsigned int *a, unsigned int aCount, const unsigned int *b, unsigned int bCount) {
+        return std::lexicographical_compare(a, a + aCount, b, b + bCount);
+    }
+
+    static bool sameTextures(const unsigned int *a, unsigned int aCount, const unsigned int *b, unsigned int bCount) {
+        return aCount == bCount && std::equal(a, a + aCount, b);
+    }
+
+    StaticBatch::StaticBatch(VertexFormat format, bool indirect)
+            : m_Format(format), m_VertexSize(format == VERTEX_PACKED ? sizeof(PackedVertex) : sizeof(Vertex)),
+              m_Indirect(indirect && GLExtensions::hasMultiDrawIndirect()), m_Matrices(GL_RGBA32F) {
+        glGenVertexArrays(1, &m_VAO);
+        if (m_Indirect) {
+            glGenBuffers(1, &m_DrawIndexBuffer);
+            glGenBuffers(1, &m_IndirectBuffer);
+        }
+    }
+
+    void StaticBatch::reserveVertices(std::size_t count) {
+        std::size_t needed = m_VertexCount + count;
+        if (needed <= m_VertexCapacity) {
+            return;
+        }
+        std::size_t capacity = std::max(needed, 2 * m_VertexCapacity);
+        growBuffer(m_VertexBuffer, m_VertexCount * m_VertexSize, capacity * m_VertexSize);
+        m_VertexCapacity = capacity;
+    }
+
+    void StaticBatch::reserveIndices(std::size_t count, GLenum indexType) {
+        GLenum batchType = indexTypeSize(indexType) > indexTypeSize(m_IndexType) ? indexType : m_IndexType;
+        std::size_t needed = m_IndexCount + count;
+        if (batchType == m_IndexType && needed <= m_IndexCapacity) {
+            return;
+        }
+
+        std::size_t capacity = std::max(needed, 2 * m_IndexCapacity);
+        if (batchType == m_IndexType) {
+            growBuffer(m_IndexBuffer, m_IndexCount * indexTypeSize(m_IndexType), capacity * indexTypeSize(m_IndexType));
+        } else {
+            // only once per batch at most, everything so far goes through the CPU to be widened
+            std::vector<unsigned int> indices = readIndices(m_IndexBuffer, m_IndexType, m_IndexCount);
+            growBuffer(m_IndexBuffer, 0, capacity * indexTypeSize(batchType));
+            m_IndexType = batchType;
+            writeIndices(m_IndexBuffer, m_IndexType, 0, indices);
+        }
+        m_IndexCapacity = capacity;
+    }
+
+    unsigned int StaticBatch::packModel(const Model &model) {
+        for (unsigned int i = 0; i < m_Models.size(); ++i) {
+            if (m_Models[i].model == &model) {
+                return i;
+            }
+        }
+
+        PackedModel packed;
+        packed.model = &model;
+        packed.firstMesh = m_Meshes.size();
+        packed.meshCount = model.meshes.size();
+        for (const Mesh &mesh: model.meshes) {
+            // the vertices stay on the GPU, the indices come back once to be rewritten in the batch index type
+            reserveVertices(mesh.vertexCount);
+            glBindBuffer(GL_COPY_READ_BUFFER, mesh.VBO);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, m_VertexBuffer);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, m_VertexCount * m_VertexSize, mesh.getVertexBufferSize());
+
+            std::vector<unsigned int> indices = readIndices(mesh.EBO, mesh.indexType, mesh.indexCount);
+            reserveIndices(mesh.indexCount, mesh.indexType);
+            writeIndices(m_IndexBuffer, m_IndexType, m_IndexCount, indices);
+
+            MeshRange range;
+            range.firstIndex = m_IndexCount;
+            range.indexCount = mesh.indexCount;
+            range.baseVertex = m_VertexCount;
+            range.positionDecode = mesh.getPositionDecode();
+            range.bounds = mesh.bounds;
+            DrawItem material;
+            mesh.getMaterial().fill(material);
+            std::copy(material.textures, material.textures + material.textureCount, range.textures);
+            range.textureCount = material.textureCount;
+            m_Meshes.push_back(range);
+
+            m_VertexCount += mesh.vertexCount;
+            m_IndexCount += mesh.indexCount;
+        }
+        m_Models.push_back(packed);
+        // the buffers may have been replaced
+        setupVertexArray();
+        return m_Models.size() - 1;
+    }
+
+    void StaticBatch::setupVertexArray() {
+        GLState::bindVertexArray(m_VAO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, m_VertexBuffer);
+        setVertexAttributes(m_Format);
+        if (m_Indirect) {
+            glBindBuffer(GL_ARRAY_BUFFER, m_DrawIndexBuffer);
+            glEnableVertexAttribArray(DRAW_INDEX_LOCATION);
+            glVertexAttribIPointer(DRAW_INDEX_LOCATION, 1, GL_UNSIGNED_INT, sizeof(GLuint), (void *) 0);
+            glVertexAttribDivisor(DRAW_INDEX_LOCATION, 1);
+        }
+        GLState::bindVertexArray(0);
+    }
+
+    void StaticBatch::buildDraws() {
+        m_Draws.clear();
+        for (unsigned int object = 0; object < m_Objects.size(); ++object) {
+            const PackedModel &model = m_Models[m_Objects[object].model];
+            for (unsigned int mesh = model.firstMesh; mesh < model.firstMesh + model.meshCount; ++mesh) {
+                m_Draws.push_back(Draw{object, mesh});
+            }
+        }
+        // equal texture sets next to each other, each set is one group
+        std::stable_sort(m_Draws.begin(), m_Draws.end(), [this](const Draw &a, const Draw &b) {
+            const MeshRange &meshA = m_Meshes[a.mesh];
+            const MeshRange &meshB = m_Meshes[b.mesh];
+            return lessTextures(meshA.textures, meshA.textureCount, meshB.textures, meshB.textureCount);
+        });
+
+        m_Commands.clear();
+        m_Groups.clear();
+        for (unsigned int i = 0; i < m_Draws.size(); ++i) {
+            const MeshRange &mesh = m_Meshes[m_Draws[i].mesh];
+            DrawElementsIndirectCommand command;
+            command.count = mesh.indexCount;
+            command.instanceCount = 1;
+            command.firstIndex = mesh.firstIndex;
+            command.baseVertex = mesh.baseVertex;
+            command.baseInstance = i;
+            m_Commands.push_back(command);
+
+            if (m_Groups.empty() || !sameTextures(m_Groups.back().textures, m_Groups.back().textureCount, mesh.textures, mesh.textureCount)) {
+                Group group;
+                group.firstCommand = i;
+                group.drawCount = 0;
+                std::copy(mesh.textures, mesh.textures + mesh.textureCount, group.textures);
+                group.textureCount = mesh.textureCount;
+                m_Groups.push_back(group);
+            }
+            ++m_Groups.back().drawCount;
+        }
+        m_DrawMatrices.resize(m_Draws.size());
+
+        if (m_Indirect) {
+            std::vector<GLuint> drawIndices(m_Draws.size());
+            std::iota(drawIndices.begin(), drawIndices.end(), 0u);
+            glBindBuffer(GL_ARRAY_BUFFER, m_DrawIndexBuffer);
+            glBufferData(GL_ARRAY_BUFFER, drawIndices.size() * sizeof(GLuint), drawIndices.data(), GL_STATIC_DRAW);
+        }
+    }
+
+    StaticBatch::ObjectId StaticBatch::add(const Model &model, const glm::mat4 &matrix) {
+        ASSERT(model.isReady() && model.getVertexFormat() == m_Format, "Static batch needs a loaded model in its vertex format");
+        Object object;
+        object.model = packModel(model);
+        object.matrix = matrix;
+        m_Objects.push_back(object);
+        buildDraws();
+        return m_Objects.size() - 1;
+    }
+
+    void StaticBatch::setMatrix(ObjectId object, const glm::mat4 &matrix) {
+        m_Objects[object].matrix = matrix;
+    }
+
+    void StaticBatch::prepare(const Frustum *frustum) {
+        for (unsigned int i = 0; i < m_Draws.size(); ++i) {
+            const Object &object = m_Objects[m_Draws[i].object];
+            const MeshRange &mesh = m_Meshes[m_Draws[i].mesh];
+            m_DrawMatrices[i] = object.matrix * mesh.positionDecode;
+            m_Commands[i].instanceCount = !frustum || frustum->intersects(mesh.bounds, object.matrix) ? 1 : 0;
+        }
+
+        m_Matrices.upload(m_DrawMatrices.data(), m_DrawMatrices.size() * sizeof(glm::mat4));
+        if (m_Indirect) {
+            // orphaned like the matrices, last frame's draws may still read the old commands
+            std::size_t commandSize = m_Commands.size() * sizeof(DrawElementsIndirectCommand);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_IndirectBuffer);
+            glBufferData(GL_DRAW_INDIRECT_BUFFER, commandSize, nullptr, GL_STREAM_DRAW);
+            if (commandSize) {
+                glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, commandSize, m_Commands.data());
+            }
+        }
+
+        m_Matrices.bind(MATRIX_TEXTURE_UNIT);
+    }
+
+    void StaticBatch::Submit(RenderQueue &queue, const DrawItem &item, RenderPass pass, float depth) const {
+        if (m_Commands.empty()) {
+            return;
+        }
+        DrawItem batchItem = item;
+        batchItem.vao = m_VAO;
+        batchItem.indexed = true;
+        batchItem.indexType = m_IndexType;
+        batchItem.commands = m_Commands.data();
+        batchItem.indirectBuffer = m_Indirect ? m_IndirectBuffer : 0;
+
+        if (pass == PASS_DEPTH) {
+            batchItem.firstCommand = 0;
+            batchItem.drawCount = m_Commands.size();
+            batchItem.textureCount = 0;
+            queue.submit(batchItem, pass, depth);
+            return;
+        }
+        for (const Group &group: m_Groups) {
+            DrawItem groupItem = batchItem;
+            groupItem.firstCommand = group.firstCommand;
+            groupItem.drawCount = group.drawCount;
+            if (item.textureCount == 0) {
+                std::copy(group.textures, group.textures + group.textureCount, groupItem.textures);
+                groupItem.textureCount = group.textureCount;
+            }
+            queue.submit(groupItem, pass, depth);
+        }
+    }
+
+    unsigned int StaticBatch::getDrawCount() const {
+        return m_Commands.size();
+    }
+
+    unsigned int StaticBatch::getGroupCount() const {
+        return m_Groups.size();
+    }
+
+    bool StaticBatch::isIndirect() const {
+        return m_Indirect;
+    }
+
+    std::size_t StaticBatch::getVertexBufferSize() const {
+        return m_VertexCount * m_VertexSize;
+    }
+
+    std::size_t StaticBatch::getIndexBufferSize() const {
+        return m_IndexCount * indexTypeSize(m_IndexType);
+    }
+
+    void StaticBatch::free() {
+        GLState::deleteVertexArrays(1, &m_VAO);
+        unsigned int buffers[] = {m_VertexBuffer, m_IndexBuffer, m_DrawIndexBuffer, m_IndirectBuffer};
+        glDeleteBuffers(4, buffers);
+        m_Matrices.free();
+        m_VAO = m_VertexBuffer = m_IndexBuffer = m_DrawIndexBuffer = m_IndirectBuffer = 0;
+    }
+
+}
@@ -0,0 +1,43 @@
+#include "rg/TextureBuffer.h"
+#include "rg/GLState.h"
+
+#include <algorithm>
+
+namespace rg {
+
+    TextureBuffer::TextureBuffer(GLenum format) {
+        glGenBuffers(1, &m_Buffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, m_Buffer);
+        // a buffer texture needs storage behind it even when empty
+        glBufferData(GL_TEXTURE_BUFFER, 16, NULL, GL_STREAM_DRAW);
+        glGenTextures(1, &m_Texture);
+        glBindTexture(GL_TEXTURE_BUFFER, m_Texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, format, m_Buffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    void TextureBuffer::upload(const void *data, std::size_t size) {
+        glBindBuffer(GL_TEXTURE_BUFFER, m_Buffer);
+        // orphan, last frame's draws may still read the old contents
+        glBufferData(GL_TEXTURE_BUFFER, std::max<std::size_t>(size, 16), NULL, GL_STREAM_DRAW);
+        if (size) {
+            glBufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+        }
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    void TextureBuffer::bind(unsigned int unit) const {
+        // GLState only shadows GL_TEXTURE_2D, the buffer target of the same unit is left to us
+        GLState::activeTexture(unit);
+        glBindTexture(GL_TEXTURE_BUFFER, m_Texture);
+    }
+
+    void TextureBuffer::free() {
+        glDeleteTextures(1, &m_Texture);
+        glDeleteBuffers(1, &m_Buffer);
+        m_Texture = 0;
+        m_Buffer = 0;
+    }
+
+}
@@ -0,0 +1,124 @@
+#include "rg/TextureLoader.h"
+#include "rg/GLState.h"
+#include <stb_image.h>
+#include <iostream>
+
+namespace rg {
+
+    Image decodeImage(const std::string &path) {
+        Image image;
+        image.data = stbi_load(path.c_str(), &image.width, &image.height, &image.channels, 0);
+        return image;
+    }
+
+    void freeImage(Image &image) {
+        stbi_image_free(image.data);
+        image.data = nullptr;
+    }
+
+    void uploadImage(unsigned int texture, const Image &image, bool clampTransparent) {
+        GLenum format = GL_RED;
+        if (image.channels == 1) {
+            format = GL_RED;
+        } else if (image.channels == 3) {
+            format = GL_RGB;
+        } else if (image.channels == 4) {
+            format = GL_RGBA;
+        }
+        GLenum wrap = clampTransparent && format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT;
+
+        GLState::bindTexture(texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.data);
+        glGenerateMipmap(GL_TEXTURE_2D);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+
+    TextureLoader::TextureLoader(ThreadPool &pool)
+            : m_Pool(pool) {
+    }
+
+    TextureLoader::~TextureLoader() {
+        // workers still hold pointers into m_Requests, let them finish before it goes away
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        for (Request &request: m_Requests) {
+            m_Decoded.wait(lock, [&request] { return request.decoded; });
+            freeImage(request.image);
+        }
+    }
+
+    unsigned int TextureLoader::request(const std::string &path, bool clampTransparent) {
+        unsigned int texture;
+        glGenTextures(1, &texture);
+
+        Request *request;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Requests.emplace_back();
+            request = &m_Requests.back();
+            request->texture = texture;
+            request->path = path;
+            request->clampTransparent = clampTransparent;
+            ++m_RequestCount;
+        }
+
+        m_Pool.submit([this, request] {
+            Image image = decodeImage(request->path);
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                request->image = image;
+                request->decoded = true;
+            }
+            m_Decoded.notify_all();
+        });
+        return texture;
+    }
+
+    void TextureLoader::finish() {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        while (!m_Requests.empty()) {
+            Request &request = m_Requests.front();
+            m_Decoded.wait(lock, [&request] { return request.decoded; });
+            uploadFront(lock);
+        }
+    }
+
+    bool TextureLoader::update(std::chrono::steady_clock::time_point deadline) {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        while (!m_Requests.empty() && m_Requests.front().decoded) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                break;
+            }
+            uploadFront(lock);
+        }
+        return m_Requests.empty();
+    }
+
+    void TextureLoader::uploadFront(std::unique_lock<std::mutex> &lock) {
+        Request &request = m_Requests.front();
+
+        // the worker is done with this request, upload without blocking the others
+        lock.unlock();
+        if (request.image.data) {
+            uploadImage(request.texture, request.image, request.clampTransparent);
+        } else {
+            std::cerr << "Failed to load texture " << request.path << '\n';
+        }
+        freeImage(request.image);
+        lock.lock();
+        m_Requests.pop_front();
+        ++m_UploadCount;
+    }
+
+    std::size_t TextureLoader::getRequestCount() const {
+        return m_RequestCount;
+    }
+
+    std::size_t TextureLoader::getUploadCount() const {
+        return m_UploadCount;
+    }
+
+}
@@ -0,0 +1,68 @@
+#include "rg/ThreadPool.h"
+
+namespace rg {
+
+    ThreadPool::ThreadPool(unsigned int threadCount) {
+        if (threadCount == 0) {
+            threadCount = std::thread::hardware_concurrency();
+        }
+        if (threadCount == 0) {
+            threadCount = 1;
+        }
+        for (unsigned int i = 0; i < threadCount; ++i) {
+            m_Workers.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stopping = true;
+        }
+        m_TaskAvailable.notify_all();
+        for (std::thread &worker: m_Workers) {
+            worker.join();
+        }
+    }
+
+    void ThreadPool::submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Tasks.push_back(std::move(task));
+        }
+        m_TaskAvailable.notify_one();
+    }
+
+    void ThreadPool::wait() {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Idle.wait(lock, [this] { return m_Tasks.empty() && m_Running == 0; });
+    }
+
+    unsigned int ThreadPool::getThreadCount() const {
+        return m_Workers.size();
+    }
+
+    void ThreadPool::workerLoop() {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        while (true) {
+            m_TaskAvailable.wait(lock, [this] { return m_Stopping || !m_Tasks.empty(); });
+            if (m_Tasks.empty()) {
+                // stopping and nothing left to run
+                return;
+            }
+            std::function<void()> task = std::move(m_Tasks.front());
+            m_Tasks.pop_front();
+            ++m_Running;
+
+            lock.unlock();
+            task();
+            lock.lock();
+
+            --m_Running;
+            if (m_Tasks.empty() && m_Running == 0) {
+                m_Idle.notify_all();
+            }
+        }
+    }
+
+}
@@ -0,0 +1,31 @@
+#include "rg/UniformBuffer.h"
+#include "rg/Error.h"
+
+namespace rg {
+
+    UniformBuffer::UniformBuffer(std::size_t size, unsigned int binding)
+            : m_Binding(binding), m_Size(size) {
+        glGenBuffers(1, &m_Id);
+        glBindBuffer(GL_UNIFORM_BUFFER, m_Id);
+        glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, binding, m_Id);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    void UniformBuffer::update(const void *data, std::size_t size, std::size_t offset) {
+        ASSERT(offset + size <= m_Size, "Uniform buffer update out of range");
+        glBindBuffer(GL_UNIFORM_BUFFER, m_Id);
+        glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    unsigned int UniformBuffer::getBinding() const {
+        return m_Binding;
+    }
+
+    void UniformBuffer::free() {
+        glDeleteBuffers(1, &m_Id);
+        m_Id = 0;
+    }
+
+}
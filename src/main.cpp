@@ -13,7 +13,31 @@
 #include <learnopengl/camera.h>
 #include <rg/Hexagon.h>
 #include <rg/Texture2D.h>
-
+#include <rg/UniformBuffer.h>
+#include <rg/MeshCache.h>
+#include <rg/ThreadPool.h>
+#include <rg/TextureLoader.h>
+#include <rg/ModelLoader.h>
+#include <rg/RenderQueue.h>
+#include <rg/GLState.h>
+#include <rg/Frustum.h>
+#include <rg/InstancedModel.h>
+#include <rg/StaticBatch.h>
+#include <rg/Profiler.h>
+#include <rg/Bloom.h>
+#include <rg/GaussianKernel.h>
+#include <rg/GLExtensions.h>
+#include <rg/ComputePostProcess.h>
+#include <rg/AutoExposure.h>
+#include <rg/ClusteredLighting.h>
+#include <rg/DeferredShading.h>
+#include <rg/AllocationCounter.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
 #include <iostream>
 #include <vector>
 
@@ -33,6 +57,13 @@ bool hdr = true;
 bool hdrKeyPressed = false;
 bool bloom = true;
 bool bloomKeyPressed = false;
+bool bloomModeKeyPressed = false;
+bool computePostKeyPressed = false;
+bool autoExposureKeyPressed = false;
+bool deferredKeyPressed = false;
+bool depthPrepassKeyPressed = false;
+bool overdrawKeyPressed = false;
+bool mergedStaticKeyPressed = false;
 float exposure = 1.0f;
 
 // camera
@@ -78,6 +109,29 @@ struct ProgramState {
     float teaCupScale = 0.08f;
     float flowerScale = 0.01f;
     float windowScale = 15.0f;
+    // time per frame spent moving streamed models and textures to the GPU
+    float streamingBudgetMs = 2.0f;
+    // mip chain bloom, or the full resolution gaussian ping-pong when false
+    bool bloomMipChain = true;
+    // spread of the mip chain upsample filter, in texels of each level
+    float bloomRadius = 1.0f;
+    // width of the gaussian ping-pong blur, in texels
+    float bloomSigma = 2.0f;
+    // blur and tonemap with compute shaders when the context has them
+    bool computePost = true;
+    // exposure follows the scene luminance, Q/E only work when it is off
+    bool autoExposure = true;
+    rg::AutoExposure::Settings exposureSettings;
+    // small lights circling the butterflies, on top of the three scene lights
+    unsigned int fireflyCount = 256;
+    // opaque objects go through the G-buffer and light volumes instead of lighting every fragment
+    bool deferred = false;
+    // opaque depth is laid down first by position only shaders, the colour pass then shades only what is visible
+    bool depthPrepass = false;
+    // shows how many fragments each pixel shaded in the opaque pass instead of the scene
+    bool overdrawView = false;
+    // ballerina and butterflies from shared buffers, one multi-draw per texture set instead of a draw per mesh
+    bool mergedStatic = false;
     DirLight dirLight;
     PointLight pointLight1;
     PointLight pointLight2;
@@ -119,15 +173,115 @@ void ProgramState::LoadFromFile(std::string filename) {
     }
 }
 
+const float CAMERA_NEAR = 0.1f;
+const float CAMERA_FAR = 100.0f;
+
+// std140 mirrors of the uniform blocks shared by every scene shader,
+// a vec3 takes 16 bytes unless a scalar follows it
+const unsigned int CAMERA_BLOCK_BINDING = 0;
+const unsigned int LIGHTING_BLOCK_BINDING = 1;
+
+struct CameraBlock {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec3 viewPos;
+    float padding;
+};
+
+struct DirLightBlock {
+    glm::vec3 direction;
+    float padding0;
+    glm::vec3 ambient;
+    float padding1;
+    glm::vec3 diffuse;
+    float padding2;
+    glm::vec3 specular;
+    float padding3;
+};
+
+// the point lights themselves are in the buffer textures of rg::ClusteredLighting
+struct LightingBlock {
+    DirLightBlock dirLight;
+    glm::uvec4 clusterGrid;
+    glm::vec4 clusterParams;
+};
+
+static_assert(sizeof(CameraBlock) == 144, "CameraBlock does not match the std140 layout");
+static_assert(sizeof(LightingBlock) == 96, "LightingBlock does not match the std140 layout");
+
 ProgramState *programState;
-void setShaderUniformValues(rg::Shader& shader, DirLight& dirLight, PointLight& pointLight1, PointLight& pointLight2);
+void fillCameraBlock(CameraBlock& block);
+void fillLightingBlock(LightingBlock& block, const rg::ClusteredLighting& lighting);
+void fillPointLights(rg::ClusteredLighting& lighting, float time);
+rg::PointLightData makePointLight(const glm::vec3& position, const PointLight& pointLight, const glm::vec3& color);
+rg::DrawItem makeDepthItem(rg::DrawItem item, const rg::Shader& shader, rg::Uniform<glm::mat4> modelUniform);
 glm::mat4* getInstanceTransformationMatrices(unsigned int amount, float radius, float offset, float yoffset, float mscale);
+float cameraDepth(const glm::mat4& model, const glm::vec3& cameraPosition);
 void renderQuad();
+int runLoadBenchmark();
+
+// --benchmark [--frames=N] [--report=path] [--fragment-post] [--exposure=async|sync|off] [--deferred] [--depth-prepass] [--full-vertices] [--instances=N] [--merged] [--gpu-culling]: hidden window, offscreen target, fixed timestep and
+// a scripted camera orbit; once streaming is done the frame times of N frames go to a JSON report
+struct BenchmarkSettings {
+    bool enabled = false;
+    unsigned int warmupFrames = 60;
+    unsigned int frames = 600;
+    std::string reportPath = "benchmark_report.json";
+    // measure the quad based post processing even if compute shaders are available
+    bool fragmentPost = false;
+    // auto exposure readback, "sync" waits for the GPU every frame
+    std::string exposure = "async";
+    bool deferred = false;
+    bool depthPrepass = false;
+    // load the models with VERTEX_FULL, also outside of a benchmark
+    bool fullVertices = false;
+    // number of flowers, also outside of a benchmark
+    unsigned int flowerInstances = 80;
+    bool mergedStatic = false;
+    // tea cups and flowers culled by a compute pass and drawn indirectly, also outside of a benchmark
+    bool gpuCulling = false;
+    // --bench-load: cold and warm load times of every model instead of the scene
+    bool loadBenchmark = false;
+    // --bench-state: the scene with and without redundant state calls elided, both call counts printed
+    bool stateBenchmark = false;
+};
+
+// an instanced model of the scene with its programs
+struct InstancedDraw {
+    rg::ModelHandle model;
+    const glm::mat4* matrices;
+    unsigned int amount;
+    rg::Shader* shader;
+    rg::Uniform<glm::mat4> modelUniform;
+    rg::Shader* gBufferShader;
+    rg::Uniform<glm::mat4> gBufferModelUniform;
+    const char* scope;
+    rg::InstancedModel* instances;
+};
+
+struct BenchmarkPass {
+    std::string name;
+    double cpuMs = 0.0;
+    double gpuMs = 0.0;
+    unsigned int samples = 0;
+    bool gpu = false;
+};
+
+const float BENCHMARK_TIMESTEP = 1.0f / 60.0f;
+
+BenchmarkSettings parseBenchmarkArguments(int argc, char **argv);
+void setBenchmarkCamera(Camera& camera, float t);
+void recordBenchmarkPasses(std::vector<BenchmarkPass>& passes, const rg::Profiler& profiler);
+bool writeBenchmarkReport(const BenchmarkSettings& settings, std::vector<double> frameMs, const std::vector<BenchmarkPass>& passes,
+                          double fragmentsPerPixel, double drawAllocationsPerFrame);
 unsigned int quadVAO = 0;
 unsigned int quadVBO;
 unsigned int pingpongColorbuffers[2];
 unsigned int rboDepth;
 unsigned int colorBuffers[2];
+rg::Bloom *bloomChain = nullptr;
+rg::ComputePostProcess *computePost = nullptr;
+rg::DeferredShading *deferredShading = nullptr;
 
 std::vector<float> hexagonPositions {
         0.0f,  0.0f, 0.0f,     // center
@@ -149,12 +303,18 @@ std::vector<float> hexagonTextureCoord {
         0.75f, 0.0f    // bottom right
 };
 
-int main() {
+int main(int argc, char **argv) {
+    BenchmarkSettings benchmark = parseBenchmarkArguments(argc, argv);
+
     // glfw initialize
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    if (benchmark.enabled) {
+        // the window only provides the context, everything is drawn offscreen
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    }
 
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
@@ -172,102 +332,122 @@ int main() {
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
     glfwSetKeyCallback(window, key_callback);
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    if (!benchmark.enabled) {
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    }
 
     if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    rg::GLState::reset();
+    rg::GLExtensions::load((GLADloadproc) glfwGetProcAddress);
+
+    if (benchmark.loadBenchmark) {
+        int result = runLoadBenchmark();
+        glfwTerminate();
+        return result;
+    }
+
+    // imgui, the overlay is drawn while F1 is toggled on
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    ImGui_ImplGlfw_InitForOpenGL(window, true);
+    ImGui_ImplOpenGL3_Init("#version 330 core");
+
+    bool benchState = benchmark.stateBenchmark;
 
     programState = new ProgramState;
-    programState->LoadFromFile("resources/program_state.txt");
+    if (!benchmark.enabled) {
+        programState->LoadFromFile("resources/program_state.txt");
+    }
+    if (benchmark.fragmentPost) {
+        programState->computePost = false;
+    }
+    if (benchmark.enabled) {
+        programState->autoExposure = benchmark.exposure != "off";
+        programState->exposureSettings.sync = benchmark.exposure == "sync";
+        programState->deferred = benchmark.deferred;
+        programState->depthPrepass = benchmark.depthPrepass;
+        programState->mergedStatic = benchmark.mergedStatic;
+    }
 
     // configure global opengl state
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_CULL_FACE);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    rg::GLState::enable(GL_DEPTH_TEST);
+    rg::GLState::enable(GL_CULL_FACE);
+    rg::GLState::enable(GL_BLEND);
+    rg::GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    // models keep 20 byte packed vertices on the GPU unless --full-vertices asks for the imported 56 byte ones,
+    // their vertex shaders have to match
+    rg::VertexFormat vertexFormat = benchmark.fullVertices ? rg::VERTEX_FULL : rg::VERTEX_PACKED;
+    bool packedVertices = vertexFormat == rg::VERTEX_PACKED;
+    std::string modelVertexShader = packedVertices ? "resources/shaders/ModelShaderPacked.vs" : "resources/shaders/ModelShader.vs";
+    std::string instanceVertexShader = packedVertices ? "resources/shaders/InstanceModelPacked.vs" : "resources/shaders/InstanceModel.vs";
+    std::string modelDepthVertexShader = packedVertices ? "resources/shaders/ModelDepthPacked.vs" : "resources/shaders/ModelDepth.vs";
+    std::string instanceDepthVertexShader = packedVertices ? "resources/shaders/InstanceModelDepthPacked.vs" : "resources/shaders/InstanceModelDepth.vs";
+    std::string batchVertexShader = packedVertices ? "resources/shaders/ModelBatchPacked.vs" : "resources/shaders/ModelBatch.vs";
+    std::string batchDepthVertexShader = packedVertices ? "resources/shaders/ModelBatchDepthPacked.vs" : "resources/shaders/ModelBatchDepth.vs";
 
     // build and compile shaders
     rg::Shader hexagonShader("resources/shaders/HexagonShader.vs", "resources/shaders/HexagonShader.fs");
-    rg::Shader modelShader("resources/shaders/ModelShader.vs", "resources/shaders/ModelShader.fs");
-    rg::Shader teaCupShader("resources/shaders/InstanceModel.vs", "resources/shaders/InstanceModel.fs");
-    rg::Shader flowerShader("resources/shaders/InstanceModel.vs", "resources/shaders/InstanceModel.fs");
+    rg::Shader modelShader(modelVertexShader, "resources/shaders/ModelShader.fs");
+    rg::Shader teaCupShader(instanceVertexShader, "resources/shaders/InstanceModel.fs");
+    rg::Shader flowerShader(instanceVertexShader, "resources/shaders/InstanceModel.fs");
     rg::Shader blendingShader("resources/shaders/BlendingShader.vs", "resources/shaders/BlendingShader.fs");
     rg::Shader bloomShader("resources/shaders/bloom.vs", "resources/shaders/bloom.fs");
     rg::Shader hdrShader("resources/shaders/hdr.vs", "resources/shaders/hdr.fs");
-
-    // load models
-    rg::Model ballerina("resources/objects/ballerina_skeleton/scene.gltf");
-    rg::Model butterfly("resources/objects/butterfly/scene.gltf");
-    rg::Model teaCup("resources/objects/teaCup/scene.gltf");
-    rg::Model flower("resources/objects/flower/scene.gltf");
+    // the same objects writing the G-buffer instead of lighting
+    rg::Shader hexagonGBufferShader("resources/shaders/HexagonShader.vs", "resources/shaders/HexagonGBuffer.fs");
+    rg::Shader modelGBufferShader(modelVertexShader, "resources/shaders/ModelGBuffer.fs");
+    rg::Shader teaCupGBufferShader(instanceVertexShader, "resources/shaders/ModelGBuffer.fs");
+    rg::Shader flowerGBufferShader(instanceVertexShader, "resources/shaders/ModelGBuffer.fs");
+    // depth pre-pass, position only except for the hexagon which has to discard like its colour pass
+    rg::Shader hexagonDepthShader("resources/shaders/HexagonShader.vs", "resources/shaders/HexagonDepth.fs");
+    rg::Shader modelDepthShader(modelDepthVertexShader, "resources/shaders/depth.fs");
+    rg::Shader instanceDepthShader(instanceDepthVertexShader, "resources/shaders/depth.fs");
+    // overdraw view, every opaque fragment counts itself
+    rg::Shader hexagonOverdrawShader("resources/shaders/HexagonShader.vs", "resources/shaders/HexagonOverdraw.fs");
+    rg::Shader modelOverdrawShader(modelVertexShader, "resources/shaders/overdraw.fs");
+    rg::Shader instanceOverdrawShader(instanceVertexShader, "resources/shaders/overdraw.fs");
+    rg::Shader overdrawViewShader("resources/shaders/hdr.vs", "resources/shaders/overdrawView.fs");
+    // the merged static meshes, model matrices come from the batch instead of a uniform
+    rg::Shader batchShader(batchVertexShader, "resources/shaders/ModelShader.fs");
+    rg::Shader batchGBufferShader(batchVertexShader, "resources/shaders/ModelGBuffer.fs");
+    rg::Shader batchDepthShader(batchDepthVertexShader, "resources/shaders/depth.fs");
+    rg::Shader batchOverdrawShader(batchVertexShader, "resources/shaders/overdraw.fs");
+
+    // images are decoded and models imported on the worker threads,
+    // modelLoader.update() uploads the results a few milliseconds per frame
+    rg::ThreadPool workers;
+    rg::TextureLoader textureLoader(workers);
+    rg::ModelLoader modelLoader(workers, textureLoader);
 
     // hexagon
-    rg::Texture2D hexagonDiffuseMap("resources/textures/stone.jpg");
-    rg::Texture2D hexagonNormalMap("resources/textures/stoneNormal.jpg");
-    rg::Texture2D hexagonHeightMap("resources/textures/stoneDisplacement.jpg");
-    rg::Texture2D transparentTexture("resources/textures/stars.png");
+    rg::Texture2D hexagonDiffuseMap("resources/textures/stone.jpg", &textureLoader);
+    rg::Texture2D hexagonNormalMap("resources/textures/stoneNormal.jpg", &textureLoader);
+    rg::Texture2D hexagonHeightMap("resources/textures/stoneDisplacement.jpg", &textureLoader);
+    rg::Texture2D transparentTexture("resources/textures/stars.png", &textureLoader);
+
+    // load models
+    // the scene is drawn right away and every model shows up once it is ready
+    rg::ModelHandle ballerina = modelLoader.request("resources/objects/ballerina_skeleton/scene.gltf", vertexFormat);
+    rg::ModelHandle butterfly = modelLoader.request("resources/objects/butterfly/scene.gltf", vertexFormat);
+    rg::ModelHandle teaCup = modelLoader.request("resources/objects/teaCup/scene.gltf", vertexFormat);
+    rg::ModelHandle flower = modelLoader.request("resources/objects/flower/scene.gltf", vertexFormat);
 
     rg::Hexagon hexagon(hexagonPositions, hexagonTextureCoord, true);
     rg::Hexagon hexagonBlending(hexagonPositions, hexagonTextureCoord, false);
 
-    // transformation matrices
+    // transformation matrices, seeded from the clock; a benchmark always starts it from zero
+    if (benchmark.enabled) {
+        glfwSetTime(0.0);
+    }
     unsigned int amountc = 40;
     glm::mat4* teaCupMatrices = getInstanceTransformationMatrices(amountc, 18.0, 5.0, 30.0, programState->teaCupScale);
-    unsigned int teaCupBuffer;
-    glGenBuffers(1, &teaCupBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, teaCupBuffer);
-    glBufferData(GL_ARRAY_BUFFER, amountc * sizeof(glm::mat4), &teaCupMatrices[0], GL_STATIC_DRAW);
 
-    for (unsigned int i = 0; i < teaCup.meshes.size(); i++)
-    {
-        unsigned int teaCupVAO = teaCup.meshes[i].VAO;
-        glBindVertexArray(teaCupVAO);
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)0);
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(sizeof(glm::vec4)));
-        glEnableVertexAttribArray(5);
-        glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(2 * sizeof(glm::vec4)));
-        glEnableVertexAttribArray(6);
-        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(3 * sizeof(glm::vec4)));
-
-        glVertexAttribDivisor(3, 1);
-        glVertexAttribDivisor(4, 1);
-        glVertexAttribDivisor(5, 1);
-        glVertexAttribDivisor(6, 1);
-
-        glBindVertexArray(0);
-    }
-
-    unsigned int amountf = 80;
+    unsigned int amountf = benchmark.flowerInstances;
     glm::mat4* flowerMatrices = getInstanceTransformationMatrices(amountf, 20.0, 15.0, 40.0, programState->flowerScale);
-    unsigned int flowerBuffer;
-    glGenBuffers(1, &flowerBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, flowerBuffer);
-    glBufferData(GL_ARRAY_BUFFER, amountf * sizeof(glm::mat4), &flowerMatrices[0], GL_STATIC_DRAW);
-
-    for (unsigned int i = 0; i < flower.meshes.size(); i++)
-    {
-        unsigned int flowerVAO = flower.meshes[i].VAO;
-        glBindVertexArray(flowerVAO);
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)0);
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(sizeof(glm::vec4)));
-        glEnableVertexAttribArray(5);
-        glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(2 * sizeof(glm::vec4)));
-        glEnableVertexAttribArray(6);
-        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(3 * sizeof(glm::vec4)));
-
-        glVertexAttribDivisor(3, 1);
-        glVertexAttribDivisor(4, 1);
-        glVertexAttribDivisor(5, 1);
-        glVertexAttribDivisor(6, 1);
-
-        glBindVertexArray(0);
-    }
 
     // light
     DirLight& dirLight = programState->dirLight;
@@ -297,10 +477,10 @@ int main() {
     // hdr & bloom
     unsigned int hdrFBO;
     glGenFramebuffers(1, &hdrFBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
+    rg::GLState::bindFramebuffer(hdrFBO);
     glGenTextures(2, colorBuffers);
     for (unsigned int i = 0; i < 2; i++) {
-        glBindTexture(GL_TEXTURE_2D, colorBuffers[i]);
+        rg::GLState::bindTexture(colorBuffers[i]);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -318,14 +498,14 @@ int main() {
     glDrawBuffers(2, attachments);
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
         std::cout << "Framebuffer not complete!" << std::endl;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    rg::GLState::bindFramebuffer(0);
 
     unsigned int pingpongFBO[2];
     glGenFramebuffers(2, pingpongFBO);
     glGenTextures(2, pingpongColorbuffers);
     for (unsigned int i = 0; i < 2; i++) {
-        glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[i]);
-        glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[i]);
+        rg::GLState::bindFramebuffer(pingpongFBO[i]);
+        rg::GLState::bindTexture(pingpongColorbuffers[i]);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -336,173 +516,605 @@ int main() {
             std::cout << "Framebuffer not complete!" << std::endl;
     }
 
+    bloomChain = new rg::Bloom(SCR_WIDTH, SCR_HEIGHT);
+    deferredShading = new rg::DeferredShading(SCR_WIDTH, SCR_HEIGHT, colorBuffers[0], colorBuffers[1]);
+    if (rg::GLExtensions::hasCompute()) {
+        computePost = new rg::ComputePostProcess(SCR_WIDTH, SCR_HEIGHT);
+        if (!computePost->isValid()) {
+            std::cerr << "Compute post processing unavailable, using the fragment path" << std::endl;
+            computePost->free();
+            delete computePost;
+            computePost = nullptr;
+        }
+    }
+
+    // the tonemapped image goes to the window, or to an offscreen framebuffer when benchmarking
+    unsigned int outputFBO = 0;
+    unsigned int outputRBO = 0;
+    if (benchmark.enabled) {
+        glGenFramebuffers(1, &outputFBO);
+        rg::GLState::bindFramebuffer(outputFBO);
+        glGenRenderbuffers(1, &outputRBO);
+        glBindRenderbuffer(GL_RENDERBUFFER, outputRBO);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, SCR_WIDTH, SCR_HEIGHT);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, outputRBO);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "Framebuffer not complete!" << std::endl;
+        rg::GLState::viewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+    }
+    rg::GLState::bindFramebuffer(outputFBO);
+
+    // camera and lights live in uniform buffers shared by all scene shaders, filled once per frame
+    rg::UniformBuffer cameraBuffer(sizeof(CameraBlock), CAMERA_BLOCK_BINDING);
+    rg::UniformBuffer lightingBuffer(sizeof(LightingBlock), LIGHTING_BLOCK_BINDING);
+    rg::Shader* sceneShaders[] = {&hexagonShader, &modelShader, &teaCupShader, &flowerShader, &blendingShader,
+                                  &hexagonGBufferShader, &modelGBufferShader, &teaCupGBufferShader, &flowerGBufferShader,
+                                  &hexagonDepthShader, &modelDepthShader, &instanceDepthShader,
+                                  &hexagonOverdrawShader, &modelOverdrawShader, &instanceOverdrawShader,
+                                  &batchShader, &batchGBufferShader, &batchDepthShader, &batchOverdrawShader};
+    for (rg::Shader* shader : sceneShaders) {
+        shader->bindUniformBlock("CameraBlock", cameraBuffer.getBinding());
+        shader->bindUniformBlock("LightingBlock", lightingBuffer.getBinding());
+    }
+    deferredShading->bindUniformBlock("CameraBlock", cameraBuffer.getBinding());
+    deferredShading->bindUniformBlock("LightingBlock", lightingBuffer.getBinding());
+    CameraBlock cameraBlock;
+    LightingBlock lightingBlock;
+    // point lights are assigned to view space clusters every frame, each fragment only shades the ones of its cluster
+    rg::ClusteredLighting lighting;
+    rg::Shader* litShaders[] = {&hexagonShader, &modelShader, &teaCupShader, &flowerShader, &batchShader};
+    for (rg::Shader* shader : litShaders) {
+        shader->use();
+        shader->setInt("pointLights", rg::ClusteredLighting::LIGHT_TEXTURE_UNIT);
+        shader->setInt("clusterLights", rg::ClusteredLighting::LIGHT_TEXTURE_UNIT + 1);
+        shader->setInt("lightIndices", rg::ClusteredLighting::LIGHT_TEXTURE_UNIT + 2);
+    }
+
+    // uniform handles, resolved once so the render loop never looks a uniform up by name
+    rg::Uniform<glm::mat4> hexagonModel = hexagonShader.uniform<glm::mat4>("model");
+    rg::Uniform<glm::mat4> modelModel = modelShader.uniform<glm::mat4>("model");
+    rg::Uniform<glm::mat4> hexagonGBufferModel = hexagonGBufferShader.uniform<glm::mat4>("model");
+    rg::Uniform<glm::mat4> modelGBufferModel = modelGBufferShader.uniform<glm::mat4>("model");
+    rg::Uniform<glm::mat4> hexagonDepthModel = hexagonDepthShader.uniform<glm::mat4>("model");
+    rg::Uniform<glm::mat4> modelDepthModel = modelDepthShader.uniform<glm::mat4>("model");
+    rg::Uniform<glm::mat4> hexagonOverdrawModel = hexagonOverdrawShader.uniform<glm::mat4>("model");
+    rg::Uniform<glm::mat4> modelOverdrawModel = modelOverdrawShader.uniform<glm::mat4>("model");
+    // instanced programs only have a model matrix with packed vertices, it decodes their positions
+    rg::Uniform<glm::mat4> teaCupModel = teaCupShader.uniform<glm::mat4>("model");
+    rg::Uniform<glm::mat4> flowerModel = flowerShader.uniform<glm::mat4>("model");
+    rg::Uniform<glm::mat4> teaCupGBufferModel = teaCupGBufferShader.uniform<glm::mat4>("model");
+    rg::Uniform<glm::mat4> flowerGBufferModel = flowerGBufferShader.uniform<glm::mat4>("model");
+    rg::Uniform<glm::mat4> instanceDepthModel = instanceDepthShader.uniform<glm::mat4>("model");
+    rg::Uniform<glm::mat4> instanceOverdrawModel = instanceOverdrawShader.uniform<glm::mat4>("model");
+
+    // the instanced models need the model bounds, they are created once the models are ready
+    InstancedDraw instancedDraws[] = {
+            {teaCup, teaCupMatrices, amountc, &teaCupShader, teaCupModel, &teaCupGBufferShader, teaCupGBufferModel, "tea cups", nullptr},
+            {flower, flowerMatrices, amountf, &flowerShader, flowerModel, &flowerGBufferShader, flowerGBufferModel, "flowers", nullptr}
+    };
+    rg::Uniform<glm::mat4> blendingModel = blendingShader.uniform<glm::mat4>("model");
+    rg::Uniform<bool> bloomHorizontal = bloomShader.uniform<bool>("horizontal");
+    rg::Uniform<int> bloomTapCount = bloomShader.uniform<int>("tapCount");
+    rg::Uniform<float> bloomOffsets = bloomShader.uniform<float>("offsets");
+    rg::Uniform<float> bloomWeights = bloomShader.uniform<float>("weights");
+    // sigma of the kernel bloom.fs holds, regenerated when ProgramState::bloomSigma changes
+    float bloomKernelSigma = -1.0f;
+    rg::Uniform<bool> hdrEnabled = hdrShader.uniform<bool>("hdr");
+    rg::Uniform<bool> hdrBloom = hdrShader.uniform<bool>("bloom");
+    rg::Uniform<float> hdrExposure = hdrShader.uniform<float>("exposure");
+    rg::Uniform<float> hdrBloomStrength = hdrShader.uniform<float>("bloomStrength");
+
+    // uniforms that never change are set once
+    for (rg::Shader* shader : {&hexagonShader, &hexagonGBufferShader, &hexagonDepthShader, &hexagonOverdrawShader}) {
+        shader->use();
+        shader->setFloat("heightScale", 0.1f);
+        shader->setInt("material.diffuseMap", 0);
+        shader->setInt("material.normalMap", 1);
+        shader->setInt("material.depthMap", 2);
+        shader->setFloat("material.shininess", 32.0f);
+    }
+    for (rg::Shader* shader : {&modelShader, &modelGBufferShader, &batchShader, &batchGBufferShader}) {
+        shader->use();
+        shader->setFloat("material.shininess", 32.0f);
+    }
+    for (rg::Shader* shader : {&batchShader, &batchGBufferShader, &batchDepthShader, &batchOverdrawShader}) {
+        shader->use();
+        shader->setInt("drawMatrices", rg::StaticBatch::MATRIX_TEXTURE_UNIT);
+    }
+    for (rg::Shader* shader : {&teaCupShader, &flowerShader, &teaCupGBufferShader, &flowerGBufferShader}) {
+        shader->use();
+        shader->setInt("material.diffuseMap", 0);
+        shader->setInt("material.specularMap", 1);
+        shader->setFloat("material.shininess", 32.0f);
+    }
+    blendingShader.use();
+    blendingShader.setInt("texture1", 0);
     bloomShader.use();
     bloomShader.setInt("image", 0);
     hdrShader.use();
     hdrShader.setInt("hdrBuffer", 0);
     hdrShader.setInt("bloomBlur", 1);
+    overdrawViewShader.use();
+    overdrawViewShader.setInt("counts", 0);
+
+    rg::RenderQueue renderQueue;
+    // every model goes in once it is ready, the batch only copies the butterfly geometry once
+    rg::StaticBatch staticBatch(vertexFormat);
+    rg::StaticBatch::ObjectId ballerinaObject = rg::StaticBatch::INVALID_OBJECT;
+    rg::StaticBatch::ObjectId butterflyObjects[2] = {rg::StaticBatch::INVALID_OBJECT, rg::StaticBatch::INVALID_OBJECT};
+    rg::Profiler profiler;
+    rg::AutoExposure autoExposure;
+    double statsTime = glfwGetTime();
+
+    // samples passing the depth test in the opaque pass, the fragments actually shaded;
+    // two queries in turn, each read back when it comes around again a frame later
+    unsigned int fragmentQueries[2];
+    glGenQueries(2, fragmentQueries);
+    bool fragmentQueryIssued[2] = {false, false};
+    unsigned int fragmentQueryIndex = 0;
+    double fragmentsPerPixel = 0.0;
+    double benchmarkFragments = 0.0;
+    std::uint64_t benchmarkAllocations = 0;
+
+    // --bench-state: once streaming is done, STATE_BENCH_FRAMES frames forward every call, as many elide
+    const unsigned int STATE_BENCH_FRAMES = 300;
+    unsigned int stateBenchFrame = 0;
+    unsigned long stateBenchCalls[2] = {0, 0};
+    rg::GLState::setElide(!benchState);
+
+    unsigned int benchmarkFrame = 0;
+    std::vector<double> benchmarkFrameMs;
+    std::vector<BenchmarkPass> benchmarkPasses;
 
     // render loop
     while (!glfwWindowShouldClose(window)) {
+        auto frameStart = std::chrono::steady_clock::now();
+
         // per-frame time logic
-        float currentFrame = glfwGetTime();
+        float currentFrame = benchmark.enabled ? benchmarkFrame * BENCHMARK_TIMESTEP : glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
+        profiler.beginFrame();
+        profiler.begin("frame", false);
+
         // input
-        processInput(window);
+        if (benchmark.enabled) {
+            setBenchmarkCamera(programState->camera, (float) benchmarkFrame / (benchmark.warmupFrames + benchmark.frames));
+        } else {
+            processInput(window);
+        }
+
+        // streaming
+        profiler.begin("streaming", false);
+        modelLoader.update(programState->streamingBudgetMs);
+        profiler.end();
 
         // Render
-        glClearColor(programState->clearColor.r, programState->clearColor.g, programState->clearColor.b, 1.0f);
+        bool overdraw = programState->overdrawView;
+        // the overdraw view counts fragments in the red channel and has no lighting pass of its own
+        bool deferred = programState->deferred && !overdraw;
+        bool depthPrepass = programState->depthPrepass;
+        glm::vec3 clearColor = overdraw ? glm::vec3(0.0f) : programState->clearColor;
+        glClearColor(clearColor.r, clearColor.g, clearColor.b, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
+        rg::GLState::bindFramebuffer(hdrFBO);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        fillCameraBlock(cameraBlock);
+        cameraBuffer.update(&cameraBlock, sizeof(CameraBlock));
+
+        profiler.begin("light clusters", false);
+        fillPointLights(lighting, currentFrame);
+        if (deferred) {
+            // the light volumes find their pixels on their own
+            lighting.uploadLights();
+        } else {
+            lighting.setProjection(glm::radians(programState->camera.Zoom), (float) Width / (float) Height, CAMERA_NEAR, CAMERA_FAR, (int) Width, (int) Height);
+            lighting.update(cameraBlock.view);
+        }
+        lighting.bind();
+        profiler.end();
+        fillLightingBlock(lightingBlock, lighting);
+        lightingBuffer.update(&lightingBlock, sizeof(LightingBlock));
+
+        // everything in the hdr framebuffer goes through the render queue, which orders the draws by state;
+        // heap allocations from here to the end of the transparent pass are counted for the benchmark
+        std::uint64_t drawAllocations = rg::allocationCount();
+        profiler.begin("submit", false);
+        renderQueue.clear();
+        glm::vec3 cameraPosition = programState->camera.Position;
+        rg::Frustum frustum(cameraBlock.projection * cameraBlock.view);
+
         // hexagon
-        hexagonShader.use();
-        setShaderUniformValues(hexagonShader, dirLight, pointLight1, pointLight2);
-        hexagonShader.setVec3("lightPos", pointLight1.position);
+        rg::DrawItem hexagonItem;
+        hexagonItem.program = overdraw ? hexagonOverdrawShader.getId() : deferred ? hexagonGBufferShader.getId() : hexagonShader.getId();
+        hexagonItem.textures[0] = hexagonDiffuseMap.getId();
+        hexagonItem.textures[1] = hexagonNormalMap.getId();
+        hexagonItem.textures[2] = hexagonHeightMap.getId();
+        hexagonItem.textureCount = 3;
+        hexagonItem.cullFace = GL_BACK;
+        hexagonItem.frontFace = GL_CW;
+        hexagonItem.modelUniform = overdraw ? hexagonOverdrawModel : deferred ? hexagonGBufferModel : hexagonModel;
+        hexagonItem.scope = "hexagon";
         glm::mat4 model = glm::mat4(1.0f);
         model = glm::translate(model,programState->hexagonPosition);
         model = glm::scale(model, glm::vec3(programState->hexagonScale));
         model = glm::rotate(model, (float) glm::radians(90.f), glm::vec3(1.0f, 0.0f, 0.0f));
-        hexagonShader.setMat4("model", model);
-        hexagonShader.setFloat("heightScale", 0.1f);
-
-        hexagonShader.setInt("material.diffuseMap", 0);
-        hexagonShader.setInt("material.normalMap", 1);
-        hexagonShader.setInt("material.depthMap", 2);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, hexagonDiffuseMap.getId());
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, hexagonNormalMap.getId());
-        glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, hexagonHeightMap.getId());
-
-        glCullFace(GL_BACK);
-        glFrontFace(GL_CW);
-        hexagon.drawHexagon();
-        glCullFace(GL_FRONT);
-
-        // ballerina
-        modelShader.use();
-        setShaderUniformValues(modelShader, dirLight, pointLight1, pointLight2);
-        model = glm::mat4 (1.0f);
-        model = glm::scale(model, glm::vec3(programState->ballerinaScale));
-        model = glm::rotate(model, (float) glm::radians(-90.f), glm::vec3(1.0f, 0.0f, 0.0f));
-        model = glm::translate(model,programState->ballerinaPosition);
-        modelShader.setMat4("model", model);
-        ballerina.Draw(modelShader);
+        hexagonItem.model = model;
+        hexagon.submitHexagon(renderQueue, hexagonItem, rg::PASS_OPAQUE, cameraDepth(model, cameraPosition));
+        if (depthPrepass) {
+            hexagon.submitHexagon(renderQueue, makeDepthItem(hexagonItem, hexagonDepthShader, hexagonDepthModel),
+                                  rg::PASS_DEPTH, cameraDepth(model, cameraPosition));
+        }
+
+        // models
+        glm::mat4 ballerinaMatrix = glm::mat4(1.0f);
+        ballerinaMatrix = glm::scale(ballerinaMatrix, glm::vec3(programState->ballerinaScale));
+        ballerinaMatrix = glm::rotate(ballerinaMatrix, (float) glm::radians(-90.f), glm::vec3(1.0f, 0.0f, 0.0f));
+        ballerinaMatrix = glm::translate(ballerinaMatrix, programState->ballerinaPosition);
 
-        // butterfly
+        glm::mat4 butterflyMatrices[2];
         model = glm::mat4 (1.0f);
         model = glm::scale(model, glm::vec3(0.8f * programState->butterflyScale));
         model = glm::rotate(model, (float) glm::radians(-90.f), glm::vec3(1.0f, 0.0f, 0.0f));
         model = glm::translate(model,programState->butterflyPosition1 + glm::vec3(sin(1.2*(float)currentFrame), sin(0.8*(float)currentFrame), 0.0f));
-        modelShader.setMat4("model", model);
-        butterfly.Draw(modelShader);
+        butterflyMatrices[0] = model;
 
         model = glm::mat4 (1.0f);
         model = glm::scale(model, glm::vec3(programState->butterflyScale));
         model = glm::rotate(model, (float) glm::radians(-90.f), glm::vec3(1.0f, 0.0f, 0.0f));
         model = glm::rotate(model, glm::radians((float)currentFrame * -20), glm::normalize(glm::vec3(0.2f, 0.5f, 0.5f)));
         model = glm::translate(model,programState->butterflyPosition2);
-        modelShader.setMat4("model", model);
-        butterfly.Draw(modelShader);
-
-        // tea cup
-        teaCupShader.use();
-        setShaderUniformValues(teaCupShader, dirLight, pointLight1, pointLight2);
-        teaCupShader.setInt("material.diffuseMap", 0);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, teaCup.loaded_textures[0].id);
-        teaCupShader.setInt("material.specularMap", 1);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, teaCup.loaded_textures[0].id);
-        for (unsigned int i = 0; i < teaCup.meshes.size(); i++)
-        {
-            glBindVertexArray(teaCup.meshes[i].VAO);
-            glDrawElementsInstanced(GL_TRIANGLES, teaCup.meshes[i].indices.size(), GL_UNSIGNED_INT, 0, amountc);
-            glBindVertexArray(0);
+        butterflyMatrices[1] = model;
+
+        if (programState->mergedStatic) {
+            if (ballerinaObject == rg::StaticBatch::INVALID_OBJECT && ballerina.isReady()) {
+                ballerinaObject = staticBatch.add(*ballerina, ballerinaMatrix);
+            }
+            if (butterflyObjects[0] == rg::StaticBatch::INVALID_OBJECT && butterfly.isReady()) {
+                for (unsigned int i = 0; i < 2; ++i) {
+                    butterflyObjects[i] = staticBatch.add(*butterfly, butterflyMatrices[i]);
+                }
+            }
+            if (ballerinaObject != rg::StaticBatch::INVALID_OBJECT) {
+                staticBatch.setMatrix(ballerinaObject, ballerinaMatrix);
+            }
+            if (butterflyObjects[0] != rg::StaticBatch::INVALID_OBJECT) {
+                for (unsigned int i = 0; i < 2; ++i) {
+                    staticBatch.setMatrix(butterflyObjects[i], butterflyMatrices[i]);
+                }
+            }
+            staticBatch.prepare(&frustum);
+
+            rg::DrawItem batchItem;
+            batchItem.program = overdraw ? batchOverdrawShader.getId() : deferred ? batchGBufferShader.getId() : batchShader.getId();
+            batchItem.cullFace = GL_FRONT;
+            batchItem.frontFace = GL_CW;
+            batchItem.scope = "static batch";
+            staticBatch.Submit(renderQueue, batchItem, rg::PASS_OPAQUE, cameraDepth(ballerinaMatrix, cameraPosition));
+            if (depthPrepass) {
+                staticBatch.Submit(renderQueue, makeDepthItem(batchItem, batchDepthShader, rg::Uniform<glm::mat4>()), rg::PASS_DEPTH,
+                                   cameraDepth(ballerinaMatrix, cameraPosition));
+            }
+        } else {
+            rg::DrawItem modelItem;
+            modelItem.program = overdraw ? modelOverdrawShader.getId() : deferred ? modelGBufferShader.getId() : modelShader.getId();
+            modelItem.cullFace = GL_FRONT;
+            modelItem.frontFace = GL_CW;
+            modelItem.modelUniform = overdraw ? modelOverdrawModel : deferred ? modelGBufferModel : modelModel;
+
+            // ballerina
+            modelItem.scope = "ballerina";
+            modelItem.model = ballerinaMatrix;
+            ballerina->Submit(renderQueue, modelItem, rg::PASS_OPAQUE, cameraDepth(ballerinaMatrix, cameraPosition), &frustum);
+            if (depthPrepass) {
+                ballerina->Submit(renderQueue, makeDepthItem(modelItem, modelDepthShader, modelDepthModel), rg::PASS_DEPTH,
+                           cameraDepth(ballerinaMatrix, cameraPosition), &frustum);
+            }
+
+            // butterflies
+            modelItem.scope = "butterflies";
+            for (const glm::mat4& butterflyMatrix : butterflyMatrices) {
+                modelItem.model = butterflyMatrix;
+                butterfly->Submit(renderQueue, modelItem, rg::PASS_OPAQUE, cameraDepth(butterflyMatrix, cameraPosition), &frustum);
+                if (depthPrepass) {
+                    butterfly->Submit(renderQueue, makeDepthItem(modelItem, modelDepthShader, modelDepthModel), rg::PASS_DEPTH,
+                               cameraDepth(butterflyMatrix, cameraPosition), &frustum);
+                }
+            }
         }
 
-        // flower
-        setShaderUniformValues(flowerShader, dirLight, pointLight1, pointLight2);
-        flowerShader.setInt("material.diffuseMap", 0);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, flower.loaded_textures[0].id);
-        flowerShader.setInt("material.specularMap", 1);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, flower.loaded_textures[0].id);
-        for (unsigned int i = 0; i < flower.meshes.size(); i++)
-        {
-            glBindVertexArray(flower.meshes[i].VAO);
-            glDrawElementsInstanced(GL_TRIANGLES, flower.meshes[i].indices.size(), GL_UNSIGNED_INT, 0, amountf);
-            glBindVertexArray(0);
+        // tea cups and flowers, one instanced draw per mesh with that mesh's textures
+        for (InstancedDraw& draw : instancedDraws) {
+            if (!draw.model.isReady()) {
+                continue;
+            }
+            if (!draw.instances) {
+                draw.instances = new rg::InstancedModel(*draw.model, true, benchmark.gpuCulling);
+                for (unsigned int i = 0; i < draw.amount; ++i) {
+                    draw.instances->add(draw.matrices[i]);
+                }
+            }
+            rg::DrawItem item;
+            item.program = overdraw ? instanceOverdrawShader.getId() : deferred ? draw.gBufferShader->getId() : draw.shader->getId();
+            item.modelUniform = overdraw ? instanceOverdrawModel : deferred ? draw.gBufferModelUniform : draw.modelUniform;
+            item.cullFace = GL_FRONT;
+            item.frontFace = GL_CW;
+            item.scope = draw.scope;
+            if (draw.instances->prepare(&frustum) > 0) {
+                draw.instances->Submit(renderQueue, item, rg::PASS_OPAQUE, cameraDepth(glm::mat4(1.0f), cameraPosition));
+                if (depthPrepass) {
+                    draw.instances->Submit(renderQueue, makeDepthItem(item, instanceDepthShader, instanceDepthModel),
+                                           rg::PASS_DEPTH, cameraDepth(glm::mat4(1.0f), cameraPosition));
+                }
+            }
         }
 
         // blending
-        blendingShader.use();
-        blendingShader.setMat4("view", programState->camera.GetViewMatrix());
-        blendingShader.setMat4("projection", glm::perspective(glm::radians(programState->camera.Zoom),(float) Width / (float) Height, 0.1f, 100.0f));
+        rg::DrawItem blendingItem;
+        blendingItem.program = blendingShader.getId();
+        blendingItem.textures[0] = transparentTexture.getId();
+        blendingItem.textureCount = 1;
+        blendingItem.cullFace = GL_FRONT;
+        blendingItem.frontFace = GL_CW;
+        blendingItem.modelUniform = blendingModel;
+        blendingItem.scope = "blending";
         model = glm::mat4(1.0f);
         model = glm::translate(model,programState->windowPosition);
         model = glm::scale(model, glm::vec3(programState->windowScale));
         model = glm::rotate(model, (float) glm::radians(90.f), glm::vec3(1.0f, 0.0f, 0.0f));
-        blendingShader.setMat4("model", model);
-
-        blendingShader.setInt("texture1", 0);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, transparentTexture.getId());
-        hexagonBlending.drawHexagon();
-
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-        // blur
-        bool horizontal = true, first_iteration = true;
-        unsigned int amount = 10;
-        bloomShader.use();
-        for (unsigned int i = 0; i < amount; i++) {
-            glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[horizontal]);
-            bloomShader.setInt("horizontal", horizontal);
-            glBindTexture(GL_TEXTURE_2D, first_iteration ? colorBuffers[1] : pingpongColorbuffers[!horizontal]);
+        blendingItem.model = model;
+        hexagonBlending.submitHexagon(renderQueue, blendingItem, rg::PASS_TRANSPARENT, cameraDepth(model, cameraPosition));
+
+        profiler.end();
+
+        if (deferred) {
+            deferredShading->beginGeometry();
+        }
+        if (depthPrepass) {
+            // depth only, then the colour pass shades just the fragments that are left in front
+            rg::GLState::colorMask(false);
+            renderQueue.execute(rg::PASS_DEPTH, &profiler);
+            rg::GLState::colorMask(true);
+            rg::GLState::depthFunc(GL_EQUAL);
+            rg::GLState::depthMask(false);
+        }
+        if (overdraw) {
+            rg::GLState::blendFunc(GL_ONE, GL_ONE);
+        }
+        unsigned int fragmentQuery = fragmentQueries[fragmentQueryIndex];
+        if (fragmentQueryIssued[fragmentQueryIndex]) {
+            GLint available = 0;
+            glGetQueryObjectiv(fragmentQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available) {
+                GLuint64 samples = 0;
+                glGetQueryObjectui64v(fragmentQuery, GL_QUERY_RESULT, &samples);
+                fragmentsPerPixel = (double) samples / (Width * Height);
+            }
+        }
+        glBeginQuery(GL_SAMPLES_PASSED, fragmentQuery);
+        renderQueue.execute(rg::PASS_OPAQUE, &profiler);
+        glEndQuery(GL_SAMPLES_PASSED);
+        fragmentQueryIssued[fragmentQueryIndex] = true;
+        fragmentQueryIndex = 1 - fragmentQueryIndex;
+        rg::GLState::depthFunc(GL_LESS);
+        rg::GLState::depthMask(true);
+        rg::GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        if (deferred) {
+            profiler.begin("deferred lighting");
+            deferredShading->light(lighting.getLightCount(), glm::inverse(cameraBlock.projection * cameraBlock.view), renderQuad);
+            profiler.end();
+        }
+        if (!overdraw) {
+            // the window is blended over the lit scene, with deferred shading depth tested against the G-buffer
+            renderQueue.execute(rg::PASS_TRANSPARENT, &profiler);
+        }
+        drawAllocations = rg::allocationCount() - drawAllocations;
+
+        rg::GLState::bindFramebuffer(0);
+
+        if (programState->autoExposure && !overdraw) {
+            profiler.begin("auto exposure");
+            autoExposure.update(colorBuffers[0], deltaTime, programState->exposureSettings, renderQuad, Width, Height);
+            exposure = autoExposure.getExposure();
+            profiler.end();
+        }
+
+        if (overdraw) {
+            profiler.begin("overdraw view");
+            rg::GLState::bindFramebuffer(outputFBO);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            overdrawViewShader.use();
+            rg::GLState::bindTexture(0, colorBuffers[0]);
             renderQuad();
-            horizontal = !horizontal;
-            if (first_iteration)
-                first_iteration = false;
+            profiler.end();
+        } else if (computePost && programState->computePost) {
+            profiler.begin("compute post");
+            // the ping-pong applies the kernel five times per direction, a single pass with sqrt(5) sigma is the same blur
+            computePost->render(colorBuffers[0], colorBuffers[1], programState->bloomSigma * std::sqrt(5.0f),
+                                bloom, hdr, exposure, outputFBO);
+            profiler.end();
+        } else {
+            // blur
+            profiler.begin("bloom");
+            unsigned int bloomTexture;
+            float bloomStrength = 1.0f;
+            if (programState->bloomMipChain) {
+                bloomTexture = bloomChain->render(colorBuffers[1], programState->bloomRadius, renderQuad);
+                // level 0 holds the sum of every level
+                bloomStrength = 1.0f / bloomChain->getLevelCount();
+            } else {
+                bool horizontal = true, first_iteration = true;
+                unsigned int amount = 10;
+                bloomShader.use();
+                if (bloomKernelSigma != programState->bloomSigma) {
+                    bloomKernelSigma = programState->bloomSigma;
+                    rg::GaussianKernel kernel = rg::GaussianKernel::make(bloomKernelSigma);
+                    bloomTapCount.set((int) kernel.tapCount);
+                    glUniform1fv(bloomOffsets.location(), kernel.tapCount, kernel.offsets);
+                    glUniform1fv(bloomWeights.location(), kernel.tapCount, kernel.weights);
+                }
+                for (unsigned int i = 0; i < amount; i++) {
+                    rg::GLState::bindFramebuffer(pingpongFBO[horizontal]);
+                    bloomHorizontal.set(horizontal);
+                    rg::GLState::bindTexture(0, first_iteration ? colorBuffers[1] : pingpongColorbuffers[!horizontal]);
+                    renderQuad();
+                    horizontal = !horizontal;
+                    if (first_iteration)
+                        first_iteration = false;
+                }
+                bloomTexture = pingpongColorbuffers[!horizontal];
+            }
+            rg::GLState::bindFramebuffer(outputFBO);
+            profiler.end();
+
+            profiler.begin("hdr resolve");
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            hdrShader.use();
+            rg::GLState::bindTexture(0, colorBuffers[0]);
+            rg::GLState::bindTexture(1, bloomTexture);
+            hdrEnabled.set(hdr);
+            hdrBloom.set(bloom);
+            hdrBloomStrength.set(bloomStrength);
+            hdrExposure.set(exposure);
+            renderQuad();
+            profiler.end();
         }
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        hdrShader.use();
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, colorBuffers[0]);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[!horizontal]);
-        hdrShader.setBool("hdr", hdr);
-        hdrShader.setBool("bloom", bloom);
-        hdrShader.setFloat("exposure", exposure);
-        renderQuad();
-
-        glfwSwapBuffers(window);
+        if (programState->ImGuiEnabled) {
+            profiler.begin("imgui");
+            ImGui_ImplOpenGL3_NewFrame();
+            ImGui_ImplGlfw_NewFrame();
+            ImGui::NewFrame();
+            profiler.drawOverlay();
+            ImGui::Render();
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            profiler.end();
+        }
+        profiler.endFrame();
+
+        // debug counters of the last frame, shown in the title once a second
+        rg::Shader::endFrame();
+        rg::GLState::endFrame();
+        if (currentFrame - statsTime >= 1.0) {
+            statsTime = currentFrame;
+            const rg::RenderQueue::Stats& queueStats = renderQueue.getStats();
+            std::string title = "Trapped in a rabbit hole | uniform lookups/frame: " + std::to_string(rg::Shader::lookupsLastFrame()) +
+                                " | draws: " + std::to_string(queueStats.draws) +
+                                " binds: " + std::to_string(queueStats.binds) +
+                                " skipped: " + std::to_string(queueStats.skippedBinds) +
+                                " | gl state calls: " + std::to_string(rg::GLState::callsLastFrame()) +
+                                " elided: " + std::to_string(rg::GLState::elidedLastFrame());
+            unsigned int visibleInstances = 0;
+            unsigned int instances = 0;
+            bool gpuCulled = false;
+            for (const InstancedDraw& draw : instancedDraws) {
+                if (draw.instances) {
+                    visibleInstances += draw.instances->getVisibleCount();
+                    instances += draw.instances->getCount();
+                    gpuCulled = gpuCulled || draw.instances->isGpuCulled();
+                }
+            }
+            // the GPU keeps its visible count to itself
+            title += " | instances: " + (gpuCulled ? std::to_string(instances) + " gpu culled"
+                                                   : std::to_string(visibleInstances) + "/" + std::to_string(instances));
+            if (programState->mergedStatic) {
+                title += " | merged: " + std::to_string(staticBatch.getDrawCount()) + " meshes in " +
+                         std::to_string(staticBatch.getGroupCount()) + (staticBatch.isIndirect() ? " multi-draws" : " loops");
+            }
+            char fragments[32];
+            std::snprintf(fragments, sizeof(fragments), "%.2f", fragmentsPerPixel);
+            title += " | fragments/pixel: " + std::string(fragments) + (depthPrepass ? " prepass" : "");
+            title += " | lights: " + std::to_string(lighting.getLightCount());
+            if (deferred) {
+                title += " deferred";
+            } else {
+                title += " max/cluster: " + std::to_string(lighting.getMaxLightsPerCluster());
+            }
+            glfwSetWindowTitle(window, title.c_str());
+        }
+
+        if (benchState && modelLoader.getPendingCount() == 0) {
+            stateBenchCalls[stateBenchFrame >= STATE_BENCH_FRAMES] += rg::GLState::callsLastFrame();
+            if (++stateBenchFrame == 2 * STATE_BENCH_FRAMES) {
+                double forwarded = (double) stateBenchCalls[0] / STATE_BENCH_FRAMES;
+                double elided = (double) stateBenchCalls[1] / STATE_BENCH_FRAMES;
+                std::printf("gl state calls/frame: %.1f forwarded, %.1f with elision (%.1f%% fewer)\n",
+                            forwarded, elided, forwarded > 0.0 ? 100.0 * (forwarded - elided) / forwarded : 0.0);
+                glfwSetWindowShouldClose(window, true);
+            }
+            rg::GLState::setElide(stateBenchFrame >= STATE_BENCH_FRAMES);
+        }
+
+        if (benchmark.enabled) {
+            // the frame is only done once the GPU is
+            glFinish();
+            if (modelLoader.getPendingCount() == 0) {
+                if (benchmarkFrame >= benchmark.warmupFrames) {
+                    benchmarkFrameMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
+                    recordBenchmarkPasses(benchmarkPasses, profiler);
+                    benchmarkFragments += fragmentsPerPixel;
+                    benchmarkAllocations += drawAllocations;
+                }
+                if (++benchmarkFrame == benchmark.warmupFrames + benchmark.frames) {
+                    if (!writeBenchmarkReport(benchmark, benchmarkFrameMs, benchmarkPasses, benchmarkFragments / benchmark.frames,
+                                              (double) benchmarkAllocations / benchmark.frames)) {
+                        std::cerr << "Failed to write " << benchmark.reportPath << '\n';
+                    }
+                    glfwSetWindowShouldClose(window, true);
+                }
+            }
+        } else {
+            glfwSwapBuffers(window);
+        }
         glfwPollEvents();
     }
 
-    glDeleteBuffers(1, &teaCupBuffer);
-    glDeleteBuffers(1, &flowerBuffer);
-    glDeleteVertexArrays(1, &quadVAO);
+    for (InstancedDraw& draw : instancedDraws) {
+        if (draw.instances) {
+            draw.instances->free();
+            delete draw.instances;
+        }
+    }
+    staticBatch.free();
+    rg::GLState::deleteVertexArrays(1, &quadVAO);
     glDeleteBuffers(1, &quadVBO);
-    glDeleteFramebuffers(1, &hdrFBO);
-    glDeleteTextures(2, colorBuffers);
+    rg::GLState::deleteFramebuffers(1, &hdrFBO);
+    rg::GLState::deleteTextures(2, colorBuffers);
     glDeleteRenderbuffers(1, &rboDepth);
-    glDeleteFramebuffers(2, pingpongFBO);
-    glDeleteTextures(2, pingpongColorbuffers);
+    rg::GLState::deleteFramebuffers(2, pingpongFBO);
+    if (outputFBO) {
+        rg::GLState::deleteFramebuffers(1, &outputFBO);
+        glDeleteRenderbuffers(1, &outputRBO);
+    }
+    rg::GLState::deleteTextures(2, pingpongColorbuffers);
+    bloomChain->free();
+    delete bloomChain;
+    deferredShading->free();
+    delete deferredShading;
+    if (computePost) {
+        computePost->free();
+        delete computePost;
+    }
+    glDeleteQueries(2, fragmentQueries);
+    cameraBuffer.free();
+    lightingBuffer.free();
+    lighting.free();
     hexagon.free();
     hexagonBlending.free();
     delete teaCupMatrices;
     delete flowerMatrices;
-    programState->SaveToFile("resources/program_state.txt");
+    profiler.free();
+    autoExposure.free();
+    ImGui_ImplOpenGL3_Shutdown();
+    ImGui_ImplGlfw_Shutdown();
+    ImGui::DestroyContext();
+    if (!benchmark.enabled) {
+        programState->SaveToFile("resources/program_state.txt");
+    }
     delete programState;
     glfwTerminate();
     return 0;
@@ -522,7 +1134,7 @@ void renderQuad()
 
         glGenVertexArrays(1, &quadVAO);
         glGenBuffers(1, &quadVBO);
-        glBindVertexArray(quadVAO);
+        rg::GLState::bindVertexArray(quadVAO);
         glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
         glEnableVertexAttribArray(0);
@@ -530,52 +1142,260 @@ void renderQuad()
         glEnableVertexAttribArray(1);
         glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
     }
-    glBindVertexArray(quadVAO);
+    // whatever winding the last model left behind, the quad is never culled; culling is on everywhere else
+    rg::GLState::disable(GL_CULL_FACE);
+    rg::GLState::bindVertexArray(quadVAO);
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    glBindVertexArray(0);
+    rg::GLState::enable(GL_CULL_FACE);
+}
+
+// loads every model once with its mesh cache removed (Assimp import + cache write) and once from the cache
+int runLoadBenchmark() {
+    const char *paths[] = {
+            "resources/objects/ballerina_skeleton/scene.gltf",
+            "resources/objects/butterfly/scene.gltf",
+            "resources/objects/teaCup/scene.gltf",
+            "resources/objects/flower/scene.gltf"
+    };
+
+    std::printf("%-50s %12s %12s %14s %14s %14s %14s %14s %14s\n", "model", "cold (ms)", "warm (ms)", "full vbo (KiB)", "packed (KiB)",
+                "32-bit ibo (KiB)", "ibo (KiB)", "cpu kept (KiB)", "cpu (KiB)");
+    for (const char *path : paths) {
+        std::remove(rg::MeshCache::pathFor(path).c_str());
+
+        auto start = std::chrono::steady_clock::now();
+        rg::Model cold(path);
+        auto middle = std::chrono::steady_clock::now();
+        rg::Model warm(path);
+        auto end = std::chrono::steady_clock::now();
+        rg::Model packed(path, nullptr, true, rg::VERTEX_PACKED);
+        rg::Model kept(path, nullptr, true, rg::VERTEX_FULL, true);
+
+        std::size_t indexCount = 0;
+        for (const rg::Mesh &mesh : warm.meshes) {
+            indexCount += mesh.indexCount;
+        }
+        std::printf("%-50s %12.2f %12.2f %14.1f %14.1f %14.1f %14.1f %14.1f %14.1f\n", path,
+                    std::chrono::duration<double, std::milli>(middle - start).count(),
+                    std::chrono::duration<double, std::milli>(end - middle).count(),
+                    warm.getVertexBufferSize() / 1024.0, packed.getVertexBufferSize() / 1024.0,
+                    indexCount * sizeof(unsigned int) / 1024.0, warm.getIndexBufferSize() / 1024.0,
+                    kept.getResidentSize() / 1024.0, warm.getResidentSize() / 1024.0);
+    }
+
+    // warm start of the whole scene with textures decoded on this thread, then on the worker pool
+    const char *textures[] = {
+            "resources/textures/stone.jpg",
+            "resources/textures/stoneNormal.jpg",
+            "resources/textures/stoneDisplacement.jpg",
+            "resources/textures/stars.png"
+    };
+    auto start = std::chrono::steady_clock::now();
+    for (const char *texture : textures) {
+        rg::Texture2D serial(texture);
+    }
+    for (const char *path : paths) {
+        rg::Model serial(path);
+    }
+    auto middle = std::chrono::steady_clock::now();
+    {
+        rg::ThreadPool workers;
+        rg::TextureLoader textureLoader(workers);
+        for (const char *texture : textures) {
+            rg::Texture2D parallel(texture, &textureLoader);
+        }
+        for (const char *path : paths) {
+            rg::Model parallel(path, &textureLoader);
+        }
+        textureLoader.finish();
+        auto end = std::chrono::steady_clock::now();
+
+        std::printf("%-50s %12.2f\n", "scene, serial texture decoding (ms)",
+                    std::chrono::duration<double, std::milli>(middle - start).count());
+        std::printf("%-50s %12.2f (%u threads)\n", "scene, parallel texture decoding (ms)",
+                    std::chrono::duration<double, std::milli>(end - middle).count(), workers.getThreadCount());
+    }
+    return 0;
 }
 
-void setShaderUniformValues(rg::Shader& shader, DirLight& dirLight, PointLight& pointLight1, PointLight& pointLight2) {
-    shader.setVec3("viewPos", programState->camera.Position);
-
-    shader.setVec3("dirLight.direction", dirLight.position);
-    shader.setVec3("dirLight.ambient", dirLight.ambient);
-    shader.setVec3("dirLight.diffuse", dirLight.diffuse);
-    shader.setVec3("dirLight.specular", dirLight.specular);
-
-    shader.setVec3("pointLight[0].position", pointLight1.position);
-    shader.setVec3("pointLight[0].ambient", pointLight1.ambient);
-    shader.setVec3("pointLight[0].diffuse", pointLight1.diffuse);
-    shader.setVec3("pointLight[0].specular", pointLight1.specular);
-    shader.setFloat("pointLight[0].constant", pointLight1.constant);
-    shader.setFloat("pointLight[0].linear", pointLight1.linear);
-    shader.setFloat("pointLight[0].quadratic", pointLight1.quadratic);
-    shader.setVec3("pointLight[0].color", glm::vec3(1.0f, 0.8f, 0.0f));
-
-    shader.setVec3("pointLight[1].position", programState->butterflyPosition1);
-    shader.setVec3("pointLight[1].ambient", pointLight2.ambient);
-    shader.setVec3("pointLight[1].diffuse", pointLight2.diffuse);
-    shader.setVec3("pointLight[1].specular", pointLight2.specular);
-    shader.setFloat("pointLight[1].constant", pointLight2.constant);
-    shader.setFloat("pointLight[1].linear", pointLight2.linear);
-    shader.setFloat("pointLight[1].quadratic", pointLight2.quadratic);
-    shader.setVec3("pointLight[1].color", glm::vec3(10.0f, 10.0f, 15.0f));
-
-    shader.setVec3("pointLight[2].position", programState->butterflyPosition2);
-    shader.setVec3("pointLight[2].ambient", pointLight2.ambient);
-    shader.setVec3("pointLight[2].diffuse", pointLight2.diffuse);
-    shader.setVec3("pointLight[2].specular", pointLight2.specular);
-    shader.setFloat("pointLight[2].constant", pointLight2.constant);
-    shader.setFloat("pointLight[2].linear", pointLight2.linear);
-    shader.setFloat("pointLight[2].quadratic", pointLight2.quadratic);
-    shader.setVec3("pointLight[2].color", glm::vec3(10.0f, 10.0f, 7.0f));
-
-    shader.setFloat("material.shininess", 32.0f);
-
-    glm::mat4 projection = glm::perspective(glm::radians(programState->camera.Zoom),(float) Width / (float) Height, 0.1f, 100.0f);
-    glm::mat4 view = programState->camera.GetViewMatrix();
-    shader.setMat4("view", view);
-    shader.setMat4("projection", projection);
+BenchmarkSettings parseBenchmarkArguments(int argc, char **argv) {
+    BenchmarkSettings settings;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument == "--benchmark") {
+            settings.enabled = true;
+        } else if (argument.compare(0, 9, "--frames=") == 0) {
+            settings.frames = std::max(1, std::atoi(argument.c_str() + 9));
+        } else if (argument.compare(0, 9, "--report=") == 0) {
+            settings.reportPath = argument.substr(9);
+        } else if (argument == "--fragment-post") {
+            settings.fragmentPost = true;
+        } else if (argument.compare(0, 11, "--exposure=") == 0) {
+            settings.exposure = argument.substr(11);
+        } else if (argument == "--deferred") {
+            settings.deferred = true;
+        } else if (argument == "--depth-prepass") {
+            settings.depthPrepass = true;
+        } else if (argument == "--full-vertices") {
+            settings.fullVertices = true;
+        } else if (argument == "--gpu-culling") {
+            settings.gpuCulling = true;
+        } else if (argument == "--merged") {
+            settings.mergedStatic = true;
+        } else if (argument == "--bench-load") {
+            settings.loadBenchmark = true;
+        } else if (argument == "--bench-state") {
+            settings.stateBenchmark = true;
+        } else if (argument.compare(0, 12, "--instances=") == 0) {
+            settings.flowerInstances = std::max(1, std::atoi(argument.c_str() + 12));
+        }
+    }
+    return settings;
+}
+
+// one orbit around the scene over the whole run, bobbing up and down and always facing the center
+void setBenchmarkCamera(Camera& camera, float t) {
+    float angle = t * glm::radians(360.0f);
+    camera.Position = glm::vec3(35.0f * cos(angle), 5.0f + 10.0f * sin(2.0f * angle), 35.0f * sin(angle));
+    glm::vec3 direction = glm::normalize(-camera.Position);
+    camera.Yaw = glm::degrees(atan2(direction.z, direction.x));
+    camera.Pitch = glm::degrees(asin(direction.y));
+    // recomputes Front, Right and Up
+    camera.ProcessMouseMovement(0.0f, 0.0f);
+}
+
+void recordBenchmarkPasses(std::vector<BenchmarkPass>& passes, const rg::Profiler& profiler) {
+    for (const rg::Profiler::Timing& timing : profiler.getTimings()) {
+        auto pass = std::find_if(passes.begin(), passes.end(), [&timing](const BenchmarkPass& pass) {
+            return pass.name == timing.name;
+        });
+        if (pass == passes.end()) {
+            passes.emplace_back();
+            pass = passes.end() - 1;
+            pass->name = timing.name;
+        }
+        pass->cpuMs += timing.cpuMs;
+        if (timing.gpuMs >= 0.0) {
+            pass->gpuMs += timing.gpuMs;
+            pass->gpu = true;
+        }
+        ++pass->samples;
+    }
+}
+
+bool writeBenchmarkReport(const BenchmarkSettings& settings, std::vector<double> frameMs, const std::vector<BenchmarkPass>& passes,
+                          double fragmentsPerPixel, double drawAllocationsPerFrame) {
+    std::ofstream out(settings.reportPath);
+    if (!out || frameMs.empty()) {
+        return false;
+    }
+
+    std::sort(frameMs.begin(), frameMs.end());
+    double sum = 0.0;
+    for (double ms : frameMs) {
+        sum += ms;
+    }
+    // nearest rank
+    auto percentile = [&frameMs](double p) {
+        std::size_t rank = (std::size_t) std::ceil(p / 100.0 * frameMs.size());
+        return frameMs[std::min(frameMs.size(), std::max<std::size_t>(rank, 1)) - 1];
+    };
+
+    out << "{\n";
+    out << "  \"renderer\": \"" << (const char*) glGetString(GL_RENDERER) << "\",\n";
+    out << "  \"post\": \"" << (computePost && programState->computePost ? "compute" : "fragment") << "\",\n";
+    out << "  \"exposure\": \"" << settings.exposure << "\",\n";
+    out << "  \"shading\": \"" << (settings.deferred ? "deferred" : "forward") << "\",\n";
+    out << "  \"depth_prepass\": " << (settings.depthPrepass ? "true" : "false") << ",\n";
+    out << "  \"vertex_format\": \"" << (settings.fullVertices ? "full" : "packed") << "\",\n";
+    out << "  \"flower_instances\": " << settings.flowerInstances << ",\n";
+    out << "  \"instance_culling\": \"" << (settings.gpuCulling && rg::InstancedModel::supportsGpuCulling() ? "gpu" : "cpu") << "\",\n";
+    out << "  \"static_meshes\": \"" << (settings.mergedStatic ? "merged" : "separate") << "\",\n";
+    out << "  \"multi_draw_indirect\": " << (rg::GLExtensions::hasMultiDrawIndirect() ? "true" : "false") << ",\n";
+    out << "  \"fragments_per_pixel\": " << fragmentsPerPixel << ",\n";
+    out << "  \"draw_allocations_per_frame\": " << drawAllocationsPerFrame << ",\n";
+    out << "  \"width\": " << SCR_WIDTH << ",\n";
+    out << "  \"height\": " << SCR_HEIGHT << ",\n";
+    out << "  \"timestep_ms\": " << BENCHMARK_TIMESTEP * 1000.0f << ",\n";
+    out << "  \"frames\": " << frameMs.size() << ",\n";
+    out << "  \"frame_ms\": {\"min\": " << frameMs.front() << ", \"avg\": " << sum / frameMs.size()
+        << ", \"p95\": " << percentile(95.0) << ", \"p99\": " << percentile(99.0) << ", \"max\": " << frameMs.back() << "},\n";
+    out << "  \"passes\": [";
+    for (std::size_t i = 0; i < passes.size(); ++i) {
+        const BenchmarkPass& pass = passes[i];
+        out << (i ? ",\n" : "\n") << "    {\"name\": \"" << pass.name << "\", \"cpu_ms_avg\": " << pass.cpuMs / pass.samples;
+        if (pass.gpu) {
+            out << ", \"gpu_ms_avg\": " << pass.gpuMs / pass.samples;
+        }
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+
+    std::printf("benchmark: %zu frames, avg %.3f ms, p95 %.3f ms, p99 %.3f ms, %.1f draw allocations/frame -> %s\n", frameMs.size(),
+                sum / frameMs.size(), percentile(95.0), percentile(99.0), drawAllocationsPerFrame, settings.reportPath.c_str());
+    return (bool) out;
+}
+
+void fillCameraBlock(CameraBlock& block) {
+    block.view = programState->camera.GetViewMatrix();
+    block.projection = glm::perspective(glm::radians(programState->camera.Zoom),(float) Width / (float) Height, CAMERA_NEAR, CAMERA_FAR);
+    block.viewPos = programState->camera.Position;
+}
+
+void fillLightingBlock(LightingBlock& block, const rg::ClusteredLighting& lighting) {
+    DirLight& dirLight = programState->dirLight;
+    block.dirLight.direction = dirLight.position;
+    block.dirLight.ambient = dirLight.ambient;
+    block.dirLight.diffuse = dirLight.diffuse;
+    block.dirLight.specular = dirLight.specular;
+
+    block.clusterGrid = lighting.getGrid();
+    block.clusterParams = lighting.getParams();
+}
+
+void fillPointLights(rg::ClusteredLighting& lighting, float time) {
+    lighting.clearLights();
+    lighting.addLight(makePointLight(programState->pointLight1.position, programState->pointLight1, glm::vec3(1.0f, 0.8f, 0.0f)));
+    lighting.addLight(makePointLight(programState->butterflyPosition1, programState->pointLight2, glm::vec3(10.0f, 10.0f, 15.0f)));
+    lighting.addLight(makePointLight(programState->butterflyPosition2, programState->pointLight2, glm::vec3(10.0f, 10.0f, 7.0f)));
+
+    // fireflies, half around each butterfly on tilted orbits; everything follows from the index and the time
+    PointLight firefly;
+    firefly.ambient = glm::vec3(0.02f);
+    firefly.diffuse = glm::vec3(1.5f);
+    firefly.specular = glm::vec3(0.5f);
+    firefly.constant = 1.0f;
+    firefly.linear = 0.7f;
+    firefly.quadratic = 1.8f;
+    for (unsigned int i = 0; i < programState->fireflyCount; ++i) {
+        glm::vec3 center = i % 2 ? programState->butterflyPosition2 : programState->butterflyPosition1;
+        float phase = i * 2.39996f;
+        float radius = 2.0f + (i % 11) * 0.6f;
+        float angle = phase + time * (0.3f + (i % 5) * 0.1f);
+        glm::vec3 offset(radius * cos(angle), 1.5f * sin(1.3f * time + phase), radius * sin(angle));
+        glm::vec3 color = i % 3 ? glm::vec3(1.0f, 0.9f, 0.4f) : glm::vec3(0.5f, 1.0f, 0.3f);
+        lighting.addLight(makePointLight(center + offset, firefly, color));
+    }
+}
+
+rg::PointLightData makePointLight(const glm::vec3& position, const PointLight& pointLight, const glm::vec3& color) {
+    rg::PointLightData light;
+    light.position = position;
+    light.ambient = pointLight.ambient;
+    light.diffuse = color * pointLight.diffuse;
+    light.specular = pointLight.specular;
+    light.constant = pointLight.constant;
+    light.linear = pointLight.linear;
+    light.quadratic = pointLight.quadratic;
+    return light;
+}
+
+// the same draw through a depth only program, timed together with every other depth draw
+rg::DrawItem makeDepthItem(rg::DrawItem item, const rg::Shader& shader, rg::Uniform<glm::mat4> modelUniform) {
+    item.program = shader.getId();
+    item.modelUniform = modelUniform;
+    item.scope = "depth prepass";
+    return item;
 }
 
 glm::mat4* getInstanceTransformationMatrices(unsigned int amount, float radius, float offset, float yoffset, float mscale) {
@@ -608,6 +1428,11 @@ glm::mat4* getInstanceTransformationMatrices(unsigned int amount, float radius,
     return modelMatrices;
 }
 
+// distance from the camera to the model origin, mapped to [0, 1] by the far plane for render queue keys
+float cameraDepth(const glm::mat4& model, const glm::vec3& cameraPosition) {
+    return glm::length(glm::vec3(model[3]) - cameraPosition) / 100.0f;
+}
+
 void processInput(GLFWwindow *window) {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
@@ -637,31 +1462,99 @@ void processInput(GLFWwindow *window) {
         bloomKeyPressed = false;
     }
 
-    if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS) {
-        if (exposure > 0.0f)
-            exposure -= 0.001f;
-        else
-            exposure = 0.0f;
+    if (glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS && !bloomModeKeyPressed) {
+        programState->bloomMipChain = !programState->bloomMipChain;
+        bloomModeKeyPressed = true;
     }
-    else if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS) {
-        exposure += 0.001f;
+    if (glfwGetKey(window, GLFW_KEY_G) == GLFW_RELEASE) {
+        bloomModeKeyPressed = false;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS && !computePostKeyPressed) {
+        programState->computePost = !programState->computePost;
+        computePostKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_C) == GLFW_RELEASE) {
+        computePostKeyPressed = false;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_X) == GLFW_PRESS && !autoExposureKeyPressed) {
+        programState->autoExposure = !programState->autoExposure;
+        autoExposureKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_X) == GLFW_RELEASE) {
+        autoExposureKeyPressed = false;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_Z) == GLFW_PRESS && !depthPrepassKeyPressed) {
+        programState->depthPrepass = !programState->depthPrepass;
+        depthPrepassKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_Z) == GLFW_RELEASE) {
+        depthPrepassKeyPressed = false;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS && !overdrawKeyPressed) {
+        programState->overdrawView = !programState->overdrawView;
+        overdrawKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_O) == GLFW_RELEASE) {
+        overdrawKeyPressed = false;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS && !mergedStaticKeyPressed) {
+        programState->mergedStatic = !programState->mergedStatic;
+        mergedStaticKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_M) == GLFW_RELEASE) {
+        mergedStaticKeyPressed = false;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS && !deferredKeyPressed) {
+        programState->deferred = !programState->deferred;
+        deferredKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_R) == GLFW_RELEASE) {
+        deferredKeyPressed = false;
+    }
+
+    // manual exposure, auto exposure overwrites it every frame
+    if (!programState->autoExposure) {
+        if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS) {
+            if (exposure > 0.0f)
+                exposure -= 0.001f;
+            else
+                exposure = 0.0f;
+        }
+        else if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS) {
+            exposure += 0.001f;
+        }
     }
 }
 
 void hdrResize() {
     for (unsigned int i = 0; i < 2; i++) {
-        glBindTexture(GL_TEXTURE_2D, colorBuffers[i]);
+        rg::GLState::bindTexture(colorBuffers[i]);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, Width, Height, 0, GL_RGBA, GL_FLOAT, NULL);
     }
     glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, Width, Height);
+    if (deferredShading) {
+        deferredShading->resize(Width, Height);
+    }
 }
 
 void bloomResize() {
     for (unsigned int i = 0; i < 2; i++) {
-        glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[i]);
+        rg::GLState::bindTexture(pingpongColorbuffers[i]);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, Width, Height, 0, GL_RGBA, GL_FLOAT, NULL);
     }
+    if (bloomChain) {
+        bloomChain->resize(Width, Height);
+    }
+    if (computePost) {
+        computePost->resize(Width, Height);
+    }
 }
 
 void framebufferSizeCallback(GLFWwindow *window, int width, int height) {
@@ -671,7 +1564,7 @@ void framebufferSizeCallback(GLFWwindow *window, int width, int height) {
     hdrResize();
     bloomResize();
 
-    glViewport(0, 0, width, height);
+    rg::GLState::viewport(0, 0, width, height);
 }
 
 void mouse_callback(GLFWwindow *window, double xpos, double ypos) {